@@ -6,6 +6,7 @@
 
 set -e
 
+libtoolize --copy --force
 aclocal
 autoheader
 automake --foreign --add-missing --copy
@@ -0,0 +1,326 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Availability over long windows from an index of the wtmp up intervals
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The index file holds the closed up intervals (from a boot to the
+ * following shutdown) found in wtmp, in time order, each with the sum of
+ * the durations of the intervals before it, followed by a header saying
+ * up to which offset wtmp was read.  Each run only reads the records
+ * appended to wtmp since then, appends the intervals they close and
+ * rewrites the header; the up time in a window is then found with a
+ * binary search.
+ *
+ * A boot without a shutdown record (a crash) is closed at the time of the
+ * last record seen before the next boot.  The availability is computed
+ * over the part of the window following the first boot in the index.
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#if HAVE_UTMPX_H
+#include <utmpx.h>
+#endif
+
+#include "availability.h"
+#include "nputils.h"
+#include "uptime.h"
+
+#define AVAIL_MAGIC    0x55504156UL	/* "UPAV" */
+#define AVAIL_VERSION  1
+
+/* records read from wtmp per read() */
+#define AVAIL_BATCH    1024
+
+struct avail_interval
+{
+  int64_t start;
+  int64_t end;
+  int64_t prefix;		/* total duration of the previous intervals */
+};
+
+struct avail_header
+{
+  uint32_t magic;
+  uint32_t version;
+  uint64_t intervals;		/* closed intervals in the index */
+  uint64_t wtmp_dev;		/* wtmp file the offset refers to */
+  uint64_t wtmp_ino;
+  uint64_t wtmp_offset;		/* bytes of wtmp already read */
+  int64_t open_start;		/* boot without shutdown yet, or 0 */
+  int64_t last_seen;		/* time of the last record read */
+  int64_t total;		/* total duration of the closed intervals */
+};
+
+/* the intervals follow the header */
+#define AVAIL_INTERVAL_OFFSET(i) \
+  ((off_t) sizeof (struct avail_header) \
+   + (off_t) (i) * (off_t) sizeof (struct avail_interval))
+
+static const struct
+{
+  const char *name;
+  time_t secs;
+} avail_windows[] = {
+  {"30d", 30 * 24 * 3600},
+  {"90d", 90 * 24 * 3600},
+  {"365d", 365 * 24 * 3600}
+};
+
+#define AVAIL_WINDOWS  (sizeof (avail_windows) / sizeof (avail_windows[0]))
+
+#if HAVE_UTMPX_H
+
+static int
+avail_close (int fd, struct avail_header *h, int64_t end)
+{
+  struct avail_interval iv;
+
+  iv.start = h->open_start;
+  iv.end = (end > iv.start) ? end : iv.start;
+  iv.prefix = h->total;
+  if (pwrite (fd, &iv, sizeof (iv), AVAIL_INTERVAL_OFFSET (h->intervals))
+      != sizeof (iv))
+    return -1;
+
+  h->intervals++;
+  h->total += iv.end - iv.start;
+  h->open_start = 0;
+
+  return 0;
+}
+
+/* Add to the index the records appended to wtmp since the last run */
+static int
+avail_update (int fd, struct avail_header *h, const char *wtmp_path)
+{
+  struct utmpx batch[AVAIL_BATCH];
+  const struct utmpx *ut;
+  struct stat st;
+  ssize_t len;
+  int wfd;
+
+  if ((wfd = open (wtmp_path, O_RDONLY | O_CLOEXEC)) < 0)
+    return -1;
+  if (fstat (wfd, &st) < 0)
+    goto fail;
+
+  /* rotated or truncated: read the new file from its start */
+  if ((uint64_t) st.st_dev != h->wtmp_dev
+      || (uint64_t) st.st_ino != h->wtmp_ino
+      || (uint64_t) st.st_size < h->wtmp_offset)
+    {
+      h->wtmp_dev = st.st_dev;
+      h->wtmp_ino = st.st_ino;
+      h->wtmp_offset = 0;
+    }
+
+  while ((len = pread (wfd, batch, sizeof (batch), h->wtmp_offset)) > 0)
+    {
+      /* leave a partially written record to the next run */
+      len -= len % sizeof (struct utmpx);
+      if (len == 0)
+	break;
+
+      for (ut = batch; (const char *) ut < (const char *) batch + len; ut++)
+	{
+	  if (ut->ut_type == BOOT_TIME)
+	    {
+	      if (h->open_start && avail_close (fd, h, h->last_seen) < 0)
+		goto fail;
+	      h->open_start = ut->ut_tv.tv_sec;
+	    }
+	  else if (ut->ut_type == RUN_LVL && h->open_start
+		   && !strncmp (ut->ut_user, "shutdown",
+				sizeof (ut->ut_user)))
+	    {
+	      if (avail_close (fd, h, ut->ut_tv.tv_sec) < 0)
+		goto fail;
+	    }
+	  h->last_seen = ut->ut_tv.tv_sec;
+	}
+      h->wtmp_offset += len;
+    }
+
+  close (wfd);
+  return (len < 0) ? -1 : 0;
+
+fail:
+  close (wfd);
+  return -1;
+}
+
+#else
+
+static int
+avail_update (int fd __attribute__ ((__unused__)),
+	      struct avail_header *h __attribute__ ((__unused__)),
+	      const char *wtmp_path __attribute__ ((__unused__)))
+{
+  return -1;
+}
+
+#endif /* HAVE_UTMPX_H */
+
+/*
+ * Up time of the closed intervals 'iv[0..n-1]' after 'since', found in
+ * O(log n) from the prefix sums
+ */
+static int64_t
+avail_closed_since (const struct avail_interval *iv, uint64_t n,
+		    int64_t total, int64_t since)
+{
+  uint64_t lo = 0, hi = n, mid;
+
+  /* first interval ending after 'since' */
+  while (lo < hi)
+    {
+      mid = lo + (hi - lo) / 2;
+      if (iv[mid].end <= since)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  if (lo == n)
+    return 0;
+
+  return total - iv[lo].prefix
+    - ((iv[lo].start < since) ? since - iv[lo].start : 0);
+}
+
+/*
+ * Update the availability index 'index_path' from the wtmp file 'wtmp_path'
+ * and check the uptime and the availability in the last 30, 90 and 365
+ * days, the latter against 'avail_threshold' (percents)
+ */
+int
+availability_check (const char *index_path, const char *wtmp_path,
+		    const thresholds * my_threshold,
+		    const thresholds * avail_threshold)
+{
+  char buf[128], msg[256], perfdata[256];
+  const struct avail_interval *iv = NULL;
+  struct avail_header h;
+  struct stat st;
+  time_t uptime_secs, now;
+  int64_t first, open_start, since, up;
+  double percent;
+  size_t i, mlen, plen, map_len = 0;
+  void *addr = NULL;
+  int fd, status, avail_status;
+
+  if (UPTIME_RET_FAIL == (uptime_secs = uptime ()))
+    {
+      printf ("UPTIME UNKNOWN: can't get system uptime counter\n");
+      return STATE_UNKNOWN;
+    }
+  now = time (NULL);
+
+  if ((fd = open (index_path, O_RDWR | O_CREAT | O_CLOEXEC, 0644)) < 0
+      || flock (fd, LOCK_EX) < 0)
+    {
+      printf ("UPTIME UNKNOWN: cannot open the index %s\n", index_path);
+      return STATE_UNKNOWN;
+    }
+
+  if (pread (fd, &h, sizeof (h), 0) != sizeof (h)
+      || h.magic != AVAIL_MAGIC || h.version != AVAIL_VERSION)
+    {
+      memset (&h, 0, sizeof (h));
+      h.magic = AVAIL_MAGIC;
+      h.version = AVAIL_VERSION;
+    }
+
+  /* the intervals are written before the header that counts them */
+  if (avail_update (fd, &h, wtmp_path) < 0
+      || pwrite (fd, &h, sizeof (h), 0) != sizeof (h))
+    {
+      close (fd);
+      printf ("UPTIME UNKNOWN: cannot update the index %s from %s\n",
+	      index_path, wtmp_path);
+      return STATE_UNKNOWN;
+    }
+
+  if (h.intervals > 0 && fstat (fd, &st) == 0
+      && st.st_size >= AVAIL_INTERVAL_OFFSET (h.intervals))
+    {
+      map_len = (size_t) AVAIL_INTERVAL_OFFSET (h.intervals);
+      addr = mmap (NULL, map_len, PROT_READ, MAP_SHARED, fd, 0);
+      if (MAP_FAILED == addr)
+	addr = NULL;
+      else
+	iv = (const struct avail_interval *) ((char *) addr + sizeof (h));
+    }
+  close (fd);
+  if (NULL == iv)
+    h.intervals = 0;
+
+  /* the current boot, when wtmp does not have it */
+  open_start = h.open_start ? h.open_start : now - uptime_secs;
+  first = (h.intervals > 0) ? iv[0].start : open_start;
+
+  status = get_status ((unsigned int) (uptime_secs / 60), my_threshold);
+  mlen = snprintf (msg, sizeof (msg), "%s",
+		   sprint_uptime (buf, sizeof (buf), uptime_secs));
+  plen = snprintf (perfdata, sizeof (perfdata), "uptime=%u",
+		   (unsigned int) (uptime_secs / 60));
+
+  for (i = 0; i < AVAIL_WINDOWS; i++)
+    {
+      since = now - avail_windows[i].secs;
+      if (since < first)
+	since = first;
+
+      up = avail_closed_since (iv, h.intervals, h.total, since)
+	+ (now - ((open_start > since) ? open_start : since));
+      percent = (now > since) ? 100.0 * up / (now - since) : 100.0;
+      if (percent > 100.0)
+	percent = 100.0;
+
+      avail_status = get_status (percent, avail_threshold);
+      if (avail_status > status)
+	status = avail_status;
+
+      if (mlen < sizeof (msg))
+	mlen += snprintf (msg + mlen, sizeof (msg) - mlen, "%s %.3f%% in %s",
+			  (i == 0) ? ", availability" : ",", percent,
+			  avail_windows[i].name);
+      if (plen < sizeof (perfdata))
+	plen += snprintf (perfdata + plen, sizeof (perfdata) - plen,
+			  " availability_%s=%.3f%%", avail_windows[i].name,
+			  percent);
+    }
+
+  if (addr)
+    munmap (addr, map_len);
+
+  printf ("UPTIME %s: %s|%s\n", status_message (status), msg, perfdata);
+
+  return status;
+}
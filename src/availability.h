@@ -0,0 +1,6 @@
+#pragma once
+
+#include "nputils.h"
+
+int availability_check (const char *, const char *, const thresholds *,
+			const thresholds *);
@@ -0,0 +1,646 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Batch collector of the uptime files of many roots
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The sources are files in the /proc/uptime format, or directories (a
+ * mounted proc, a container rootfs with proc bind mounted) read as
+ * DIR/uptime.  With io_uring the sources are read in windows of
+ * BATCH_RING_ENTRIES: the opens, the reads and the closes of a window are
+ * each submitted, and waited for, with a single io_uring_enter(), the
+ * data landing in a registered buffer with a slot per source.  Directories
+ * are opened as well and fail the read with EISDIR: they are read again,
+ * as DIR/uptime, in a second pass.
+ *
+ * The ring is driven with the raw system calls, without liburing.  When
+ * io_uring is not available (before Linux 5.6, or disabled by the
+ * kernel.io_uring_disabled sysctl) the sources are read with open, read
+ * and close by a pool of threads, which also reads the sources left
+ * (still EINPROGRESS) when the ring fails halfway.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if HAVE_LINUX_IO_URING_H && HAVE_DECL_IORING_OP_OPENAT
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include "batch.h"
+#include "nputils.h"
+#include "procscan.h"
+#include "uptime.h"
+
+#define BATCH_RING_ENTRIES  1024
+#define BATCH_SLOT          64	/* "12345678.90 98765432.10\n" fits */
+#define BATCH_UPTIME        "uptime"
+
+/* Parse the seconds of a /proc/uptime line.  Returns 0 if okay */
+static int
+batch_parse (const char *buf, ssize_t len, time_t * uptime_secs)
+{
+  time_t secs = 0;
+  ssize_t i;
+
+  for (i = 0; i < len && buf[i] >= '0' && buf[i] <= '9'; i++)
+    secs = secs * 10 + (buf[i] - '0');
+  if (i == 0 || (i < len && buf[i] != '.' && buf[i] != ' '))
+    return -1;
+
+  *uptime_secs = secs;
+  return 0;
+}
+
+static void
+batch_add (struct batch_stats *stats, unsigned long syscalls)
+{
+  __atomic_add_fetch (&stats->syscalls, syscalls, __ATOMIC_RELAXED);
+}
+
+#if HAVE_LINUX_IO_URING_H && HAVE_DECL_IORING_OP_OPENAT
+
+struct batch_ring
+{
+  int fd;
+  void *sq_ptr, *cq_ptr;
+  size_t sq_len, cq_len;
+  struct io_uring_sqe *sqes;
+  size_t sqes_len;
+  unsigned int *sq_tail, *sq_mask, *sq_array;
+  unsigned int *cq_head, *cq_tail, *cq_mask;
+  struct io_uring_cqe *cqes;
+  int fixed;			/* the slots are a registered buffer */
+};
+
+static int
+batch_ring_enter (struct batch_ring *ring, unsigned int to_submit,
+		  unsigned int min_complete)
+{
+  return (int) syscall (__NR_io_uring_enter, ring->fd, to_submit,
+			min_complete, IORING_ENTER_GETEVENTS, NULL, 0);
+}
+
+static void
+batch_ring_exit (struct batch_ring *ring, struct batch_stats *stats)
+{
+  unsigned long syscalls = 1;
+
+  if (ring->sqes && ring->sqes != MAP_FAILED && ++syscalls)
+    munmap (ring->sqes, ring->sqes_len);
+  if (ring->cq_ptr && ring->cq_ptr != MAP_FAILED
+      && ring->cq_ptr != ring->sq_ptr && ++syscalls)
+    munmap (ring->cq_ptr, ring->cq_len);
+  if (ring->sq_ptr && ring->sq_ptr != MAP_FAILED && ++syscalls)
+    munmap (ring->sq_ptr, ring->sq_len);
+  close (ring->fd);
+  batch_add (stats, syscalls);
+}
+
+/*
+ * Set up a ring able to open, read and close files, and register the
+ * 'slots' buffer.  Returns 0 if okay
+ */
+static int
+batch_ring_init (struct batch_ring *ring, void *slots, size_t size,
+		 struct batch_stats *stats)
+{
+  static const unsigned char ops[] =
+    { IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE };
+  struct io_uring_params params;
+  struct io_uring_probe *probe;
+  struct iovec iov;
+  size_t i, probe_len;
+  int ret;
+
+  memset (ring, 0, sizeof (*ring));
+  memset (&params, 0, sizeof (params));
+  ring->fd = (int) syscall (__NR_io_uring_setup, BATCH_RING_ENTRIES,
+			    &params);
+  batch_add (stats, 1);
+  if (ring->fd < 0)
+    return -1;
+
+  /* IORING_OP_OPENAT and IORING_OP_CLOSE appeared in Linux 5.6 */
+  probe_len = sizeof (*probe) + 256 * sizeof (struct io_uring_probe_op);
+  if ((probe = calloc (1, probe_len)) == NULL)
+    {
+      close (ring->fd);
+      batch_add (stats, 1);
+      return -1;
+    }
+  ret = (int) syscall (__NR_io_uring_register, ring->fd,
+		       IORING_REGISTER_PROBE, probe, 256);
+  batch_add (stats, 1);
+  for (i = 0; ret == 0 && i < sizeof (ops); i++)
+    if (ops[i] > probe->last_op
+	|| !(probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED))
+      ret = -1;
+  free (probe);
+  if (ret < 0)
+    {
+      close (ring->fd);
+      batch_add (stats, 1);
+      return -1;
+    }
+
+  ring->sq_len = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+  ring->cq_len = params.cq_off.cqes
+    + params.cq_entries * sizeof (struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+      if (ring->cq_len > ring->sq_len)
+	ring->sq_len = ring->cq_len;
+      ring->cq_len = ring->sq_len;
+    }
+  ring->sq_ptr = mmap (NULL, ring->sq_len, PROT_READ | PROT_WRITE,
+		       MAP_SHARED | MAP_POPULATE, ring->fd,
+		       IORING_OFF_SQ_RING);
+  batch_add (stats, 1);
+  if (ring->sq_ptr == MAP_FAILED)
+    {
+      batch_ring_exit (ring, stats);
+      return -1;
+    }
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+    ring->cq_ptr = ring->sq_ptr;
+  else
+    {
+      ring->cq_ptr = mmap (NULL, ring->cq_len, PROT_READ | PROT_WRITE,
+			   MAP_SHARED | MAP_POPULATE, ring->fd,
+			   IORING_OFF_CQ_RING);
+      batch_add (stats, 1);
+    }
+  ring->sqes_len = params.sq_entries * sizeof (struct io_uring_sqe);
+  ring->sqes = mmap (NULL, ring->sqes_len, PROT_READ | PROT_WRITE,
+		     MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+  batch_add (stats, 1);
+  if (ring->cq_ptr == MAP_FAILED || ring->sqes == MAP_FAILED)
+    {
+      batch_ring_exit (ring, stats);
+      return -1;
+    }
+
+  ring->sq_tail = (unsigned int *) ((char *) ring->sq_ptr
+				    + params.sq_off.tail);
+  ring->sq_mask = (unsigned int *) ((char *) ring->sq_ptr
+				    + params.sq_off.ring_mask);
+  ring->sq_array = (unsigned int *) ((char *) ring->sq_ptr
+				     + params.sq_off.array);
+  ring->cq_head = (unsigned int *) ((char *) ring->cq_ptr
+				    + params.cq_off.head);
+  ring->cq_tail = (unsigned int *) ((char *) ring->cq_ptr
+				    + params.cq_off.tail);
+  ring->cq_mask = (unsigned int *) ((char *) ring->cq_ptr
+				    + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *) ((char *) ring->cq_ptr
+					+ params.cq_off.cqes);
+
+  /* the registered pages count against RLIMIT_MEMLOCK on old kernels:
+     without them plain reads are submitted */
+  iov.iov_base = slots;
+  iov.iov_len = size;
+  ring->fixed = (syscall (__NR_io_uring_register, ring->fd,
+			  IORING_REGISTER_BUFFERS, &iov, 1) == 0);
+  batch_add (stats, 1);
+
+  return 0;
+}
+
+/*
+ * Submit one operation per source of 'srcs' (at most BATCH_RING_ENTRIES)
+ * and wait for all of them: 'op' is IORING_OP_OPENAT, IORING_OP_READ or
+ * IORING_OP_CLOSE.  The results are stored in 'res', -ECANCELED for the
+ * operations not completed.  Returns 0 if okay
+ */
+static int
+batch_ring_run (struct batch_ring *ring, int op, const char **paths,
+		int *fds, char *slots, int *res, size_t n,
+		struct batch_stats *stats)
+{
+  struct io_uring_sqe *sqe;
+  struct io_uring_cqe *cqe;
+  unsigned int tail, head, mask, submitted = 0;
+  size_t i, done = 0;
+  int ret;
+
+  tail = *ring->sq_tail;
+  mask = *ring->sq_mask;
+  for (i = 0; i < n; i++)
+    {
+      if ((op == IORING_OP_OPENAT) ? paths[i] == NULL : fds[i] < 0)
+	{
+	  res[i] = -EBADF;
+	  done++;
+	  continue;
+	}
+      res[i] = -ECANCELED;
+      sqe = &ring->sqes[tail & mask];
+      memset (sqe, 0, sizeof (*sqe));
+      sqe->user_data = i;
+      switch (op)
+	{
+	case IORING_OP_OPENAT:
+	  sqe->opcode = IORING_OP_OPENAT;
+	  sqe->fd = AT_FDCWD;
+	  sqe->addr = (unsigned long) paths[i];
+	  sqe->open_flags = O_RDONLY | O_CLOEXEC;
+	  break;
+	case IORING_OP_READ:
+	  sqe->opcode = ring->fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+	  sqe->fd = fds[i];
+	  sqe->addr = (unsigned long) (slots + i * BATCH_SLOT);
+	  sqe->len = BATCH_SLOT;
+	  break;
+	default:
+	  sqe->opcode = IORING_OP_CLOSE;
+	  sqe->fd = fds[i];
+	  break;
+	}
+      ring->sq_array[tail & mask] = tail & mask;
+      tail++;
+      submitted++;
+    }
+  __atomic_store_n (ring->sq_tail, tail, __ATOMIC_RELEASE);
+
+  while (done < n)
+    {
+      ret = batch_ring_enter (ring, submitted, (unsigned int) (n - done));
+      batch_add (stats, 1);
+      if (ret < 0 && errno != EINTR)
+	return -1;
+      if (ret > 0)
+	submitted -= (unsigned int) ret;
+
+      head = *ring->cq_head;
+      while (head != __atomic_load_n (ring->cq_tail, __ATOMIC_ACQUIRE))
+	{
+	  cqe = &ring->cqes[head & *ring->cq_mask];
+	  res[cqe->user_data] = cqe->res;
+	  head++;
+	  done++;
+	}
+      __atomic_store_n (ring->cq_head, head, __ATOMIC_RELEASE);
+    }
+
+  return 0;
+}
+
+/* Close the descriptors of 'fds' opened by the ring */
+static void
+batch_close_fds (int *fds, size_t n, struct batch_stats *stats)
+{
+  size_t i;
+
+  for (i = 0; i < n; i++)
+    if (fds[i] >= 0)
+      {
+	close (fds[i]);
+	fds[i] = -1;
+	batch_add (stats, 1);
+      }
+}
+
+/*
+ * Read the sources through io_uring.  Returns 0 if okay, otherwise -1 with
+ * the sources not read yet left EINPROGRESS
+ */
+static int
+batch_read_ring (struct batch_source *sources, size_t nsources,
+		 struct batch_stats *stats)
+{
+  struct batch_ring ring;
+  const char *paths[BATCH_RING_ENTRIES];
+  char *names[BATCH_RING_ENTRIES];
+  int fds[BATCH_RING_ENTRIES], res[BATCH_RING_ENTRIES];
+  size_t first, i, n, pass;
+  char *slots;
+  int err = 0;
+
+  if ((slots = malloc (BATCH_RING_ENTRIES * BATCH_SLOT)) == NULL)
+    return -1;
+  if (batch_ring_init (&ring, slots, BATCH_RING_ENTRIES * BATCH_SLOT,
+		       stats) < 0)
+    {
+      free (slots);
+      return -1;
+    }
+
+  for (first = 0; err == 0 && first < nsources; first += n)
+    {
+      n = nsources - first;
+      if (n > BATCH_RING_ENTRIES)
+	n = BATCH_RING_ENTRIES;
+
+      memset (names, 0, sizeof (names));
+
+      /* the second pass reads DIR/uptime for the directories */
+      for (pass = 0; err == 0 && pass < 2; pass++)
+	{
+	  for (i = 0; i < n; i++)
+	    if (sources[first + i].error != (pass ? EISDIR : EINPROGRESS))
+	      paths[i] = NULL;
+	    else if (pass == 0)
+	      paths[i] = sources[first + i].path;
+	    else
+	      {
+		size_t len = strlen (sources[first + i].path);
+
+		if ((names[i] = malloc (len + sizeof (BATCH_UPTIME) + 1)))
+		  {
+		    memcpy (names[i], sources[first + i].path, len);
+		    names[i][len] = '/';
+		    memcpy (names[i] + len + 1, BATCH_UPTIME,
+			    sizeof (BATCH_UPTIME));
+		  }
+		paths[i] = names[i];
+	      }
+
+	  /* on failure the files opened are closed, and left to the pool */
+	  if (batch_ring_run (&ring, IORING_OP_OPENAT, paths, NULL, NULL,
+			      fds, n, stats) < 0
+	      || batch_ring_run (&ring, IORING_OP_READ, NULL, fds, slots,
+				 res, n, stats) < 0)
+	    {
+	      batch_close_fds (fds, n, stats);
+	      err = -1;
+	      break;
+	    }
+	  for (i = 0; i < n; i++)
+	    {
+	      if (paths[i] == NULL)
+		continue;
+	      if (fds[i] < 0)
+		sources[first + i].error = -fds[i];
+	      else if (res[i] < 0)
+		sources[first + i].error = -res[i];
+	      else if (batch_parse (slots + i * BATCH_SLOT, res[i],
+				    &sources[first + i].uptime) < 0)
+		sources[first + i].error = EINVAL;
+	      else
+		sources[first + i].error = 0;
+	    }
+	  if (batch_ring_run (&ring, IORING_OP_CLOSE, NULL, fds, NULL, res,
+			      n, stats) < 0)
+	    {
+	      for (i = 0; i < n; i++)
+		if (res[i] != -ECANCELED)
+		  fds[i] = -1;
+	      batch_close_fds (fds, n, stats);
+	      err = -1;
+	    }
+	  if (pass == 0)
+	    {
+	      for (i = 0; i < n; i++)
+		if (sources[first + i].error == EISDIR)
+		  break;
+	      if (i == n)
+		break;
+	    }
+	}
+
+      for (i = 0; i < n; i++)
+	{
+	  if (err < 0 && sources[first + i].error == EISDIR)
+	    sources[first + i].error = EINPROGRESS;
+	  free (names[i]);
+	}
+    }
+
+  batch_ring_exit (&ring, stats);
+  free (slots);
+
+  return err;
+}
+
+#endif /* HAVE_LINUX_IO_URING_H && HAVE_DECL_IORING_OP_OPENAT */
+
+struct batch_pool
+{
+  struct batch_source *sources;
+  size_t nsources;
+  size_t next;			/* first source not taken yet */
+  struct batch_stats *stats;
+};
+
+static int
+batch_read_file (const char *path, time_t * uptime_secs,
+		 struct batch_stats *stats)
+{
+  char buf[BATCH_SLOT];
+  ssize_t len;
+  int fd, err;
+
+  fd = open (path, O_RDONLY | O_CLOEXEC);
+  batch_add (stats, 1);
+  if (fd < 0)
+    return errno;
+  len = read (fd, buf, sizeof (buf));
+  err = errno;
+  close (fd);
+  batch_add (stats, 2);
+  if (len < 0)
+    return err;
+
+  return (batch_parse (buf, len, uptime_secs) < 0) ? EINVAL : 0;
+}
+
+static void *
+batch_work (void *arg)
+{
+  struct batch_pool *pool = arg;
+  struct batch_source *src;
+  char path[PATH_MAX];
+  size_t i;
+
+  while ((i = __atomic_fetch_add (&pool->next, 1, __ATOMIC_RELAXED))
+	 < pool->nsources)
+    {
+      src = &pool->sources[i];
+      if (src->error != EINPROGRESS)
+	continue;
+      src->error = batch_read_file (src->path, &src->uptime, pool->stats);
+      if (src->error == EISDIR)
+	{
+	  snprintf (path, sizeof (path), "%s/" BATCH_UPTIME, src->path);
+	  src->error = batch_read_file (path, &src->uptime, pool->stats);
+	}
+    }
+
+  return NULL;
+}
+
+/* Read the sources not read yet with a pool of 'threads' threads */
+static void
+batch_read_pool (struct batch_source *sources, size_t nsources,
+		 unsigned int threads, struct batch_stats *stats)
+{
+  struct batch_pool pool;
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+  pthread_t tid[PROCSCAN_MAX_THREADS];
+  int threaded[PROCSCAN_MAX_THREADS] = { 0 };
+#endif
+  unsigned int i;
+
+  pool.sources = sources;
+  pool.nsources = nsources;
+  pool.next = 0;
+  pool.stats = stats;
+
+#if !(HAVE_PTHREAD_H && HAVE_PTHREAD)
+  threads = 1;
+#endif
+  if (threads < 1)
+    threads = 1;
+  if (threads > PROCSCAN_MAX_THREADS)
+    threads = PROCSCAN_MAX_THREADS;
+
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+  for (i = 1; i < threads; i++)
+    threaded[i] = (pthread_create (&tid[i], NULL, batch_work, &pool) == 0);
+#endif
+  batch_work (&pool);
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+  for (i = 1; i < threads; i++)
+    if (threaded[i])
+      pthread_join (tid[i], NULL);
+#endif
+}
+
+/*
+ * Read the uptime of the 'nsources' sources with 'method' (BATCH_AUTO to
+ * use io_uring when available, or else a pool of 'threads' threads).
+ * Returns 0 if okay
+ */
+int
+batch_read (struct batch_source *sources, size_t nsources,
+	    unsigned int threads, int method, struct batch_stats *stats)
+{
+  size_t i;
+
+  memset (stats, 0, sizeof (*stats));
+  for (i = 0; i < nsources; i++)
+    sources[i].error = EINPROGRESS;
+
+#if HAVE_LINUX_IO_URING_H && HAVE_DECL_IORING_OP_OPENAT
+  if (method != BATCH_THREADS)
+    {
+      stats->method = BATCH_IO_URING;
+      if (batch_read_ring (sources, nsources, stats) == 0)
+	return 0;
+    }
+#endif
+  if (method == BATCH_IO_URING)
+    return -1;
+
+  stats->method = BATCH_THREADS;
+  batch_read_pool (sources, nsources, threads, stats);
+
+  return 0;
+}
+
+/*
+ * Check the uptime of the sources listed, one per line, in the file
+ * 'list' ("-" for the standard input), with 'threads' threads when
+ * io_uring is not available.
+ */
+int
+batch_check (const char *list, unsigned int threads,
+	     const thresholds * my_threshold)
+{
+  char *line = NULL, **paths = NULL, **tmp;
+  struct batch_source *sources = NULL;
+  struct age_target *targets = NULL;
+  struct batch_stats stats;
+  size_t i, npaths = 0, size = 0, len = 0;
+  ssize_t n;
+  FILE *fp;
+  int status;
+
+  if ((fp = (strcmp (list, "-") == 0) ? stdin : fopen (list, "r")) == NULL)
+    {
+      printf ("UPTIME UNKNOWN: cannot open %s\n", list);
+      return STATE_UNKNOWN;
+    }
+  while ((n = getline (&line, &len, fp)) >= 0)
+    {
+      while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r'))
+	line[--n] = '\0';
+      if (n == 0)
+	continue;
+      if (npaths == size)
+	{
+	  size = size ? size * 2 : 256;
+	  if ((tmp = realloc (paths, size * sizeof (*paths))) == NULL)
+	    break;
+	  paths = tmp;
+	}
+      if ((paths[npaths] = strdup (line)) == NULL)
+	break;
+      npaths++;
+    }
+  free (line);
+  if (fp != stdin)
+    fclose (fp);
+
+  if (npaths == 0
+      || (sources = calloc (npaths, sizeof (*sources))) == NULL
+      || (targets = calloc (npaths, sizeof (*targets))) == NULL)
+    {
+      printf ("UPTIME UNKNOWN: no uptime source in %s\n", list);
+      for (i = 0; i < npaths; i++)
+	free (paths[i]);
+      free (paths);
+      free (sources);
+      return STATE_UNKNOWN;
+    }
+  for (i = 0; i < npaths; i++)
+    sources[i].path = paths[i];
+
+  batch_read (sources, npaths, threads, BATCH_AUTO, &stats);
+
+  for (i = 0; i < npaths; i++)
+    {
+      targets[i].name = sources[i].path;
+      targets[i].age = sources[i].uptime;
+      targets[i].error = sources[i].error;
+    }
+  status = print_age_targets ("sources", targets, npaths, my_threshold);
+
+  for (i = 0; i < npaths; i++)
+    free (paths[i]);
+  free (targets);
+  free (sources);
+  free (paths);
+
+  return status;
+}
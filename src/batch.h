@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stddef.h>
+#include <time.h>
+
+#include "nputils.h"
+
+#define BATCH_AUTO     0
+#define BATCH_IO_URING 1
+#define BATCH_THREADS  2
+
+struct batch_source
+{
+  const char *path;		/* an uptime file, or a directory holding one */
+  time_t uptime;
+  int error;			/* errno of the failed read, or 0 */
+};
+
+struct batch_stats
+{
+  int method;			/* BATCH_IO_URING or BATCH_THREADS */
+  unsigned long syscalls;	/* issued by the collector for the reads */
+};
+
+int batch_read (struct batch_source *, size_t, unsigned int, int,
+		struct batch_stats *);
+int batch_check (const char *, unsigned int, const thresholds *);
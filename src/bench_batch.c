@@ -0,0 +1,182 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Benchmark of the batch collector of uptime files
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Usage: bench_batch [-n COUNT] [-r RUNS] [-t THREADS] DIR
+ *
+ * Creates COUNT sources (10000 by default) in DIR, one in ten being a
+ * directory holding the uptime file, and reads them RUNS times (10) with
+ * io_uring and with pools of 1 and THREADS (4) threads.  Prints, tab
+ * separated, the method, the median microseconds per run and the system
+ * calls per source.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "batch.h"
+#include "nputils.h"
+
+static long long
+nsecs (void)
+{
+  struct timespec t;
+
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return (long long) t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static int
+cmp_ll (const void *a, const void *b)
+{
+  long long x = *(const long long *) a, y = *(const long long *) b;
+
+  return (x > y) - (x < y);
+}
+
+static int
+make_sources (const char *dir, struct batch_source *sources,
+	      unsigned long count)
+{
+  char path[4096], line[64];
+  unsigned long i;
+  int fd, len;
+
+  if (mkdir (dir, 0755) < 0 && errno != EEXIST)
+    {
+      perror (dir);
+      return -1;
+    }
+  for (i = 0; i < count; i++)
+    {
+      if (i % 10 == 0)
+	{
+	  snprintf (path, sizeof (path), "%s/d%lu", dir, i);
+	  if ((mkdir (path, 0755) < 0 && errno != EEXIST)
+	      || (sources[i].path = strdup (path)) == NULL)
+	    return -1;
+	  strncat (path, "/uptime", sizeof (path) - strlen (path) - 1);
+	}
+      else
+	{
+	  snprintf (path, sizeof (path), "%s/s%lu", dir, i);
+	  if ((sources[i].path = strdup (path)) == NULL)
+	    return -1;
+	}
+      len = snprintf (line, sizeof (line), "%lu.%02lu %lu.%02lu\n",
+		      (i * 7919) % 9000000, i % 100, (i * 104729) % 9000000,
+		      (i * 3) % 100);
+      if ((fd = open (path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0
+	  || write (fd, line, len) != len || close (fd) < 0)
+	{
+	  perror (path);
+	  return -1;
+	}
+    }
+
+  return 0;
+}
+
+static void
+bench (const char *name, struct batch_source *sources, unsigned long count,
+       unsigned int runs, unsigned int threads, int method)
+{
+  struct batch_stats stats;
+  long long *t;
+  unsigned long i, errors;
+  unsigned int r;
+
+  if ((t = calloc (runs, sizeof (*t))) == NULL)
+    return;
+  for (r = 0; r < runs; r++)
+    {
+      t[r] = nsecs ();
+      if (batch_read (sources, count, threads, method, &stats) < 0)
+	{
+	  printf ("%s\tunavailable\n", name);
+	  free (t);
+	  return;
+	}
+      t[r] = nsecs () - t[r];
+    }
+  for (i = errors = 0; i < count; i++)
+    if (sources[i].error)
+      errors++;
+  qsort (t, runs, sizeof (*t), cmp_ll);
+
+  printf ("%s\t%lu\t%.1f\t%lu\t%.4f\t%lu\n", name, count,
+	  (double) t[runs / 2] / 1000.0, stats.syscalls,
+	  (double) stats.syscalls / (double) count, errors);
+  free (t);
+}
+
+int
+main (int argc, char **argv)
+{
+  struct batch_source *sources;
+  unsigned long count = 10000;
+  unsigned int runs = 10, threads = 4;
+  char name[32];
+  int c;
+
+  while ((c = getopt (argc, argv, "n:r:t:")) != -1)
+    switch (c)
+      {
+      case 'n':
+	count = strtoul (optarg, NULL, 10);
+	break;
+      case 'r':
+	runs = (unsigned int) strtoul (optarg, NULL, 10);
+	break;
+      case 't':
+	threads = (unsigned int) strtoul (optarg, NULL, 10);
+	break;
+      default:
+	count = 0;
+	break;
+      }
+
+  if (optind != argc - 1 || count == 0 || runs == 0 || threads == 0)
+    {
+      fprintf (stderr, "Usage: %s [-n COUNT] [-r RUNS] [-t THREADS] DIR\n",
+	       argv[0]);
+      return STATE_UNKNOWN;
+    }
+
+  if ((sources = calloc (count, sizeof (*sources))) == NULL
+      || make_sources (argv[optind], sources, count) < 0)
+    return STATE_UNKNOWN;
+
+  printf ("# method\tsources\tus/run\tsyscalls\tsyscalls/source\terrors\n");
+  bench ("io_uring", sources, count, runs, 1, BATCH_IO_URING);
+  bench ("threads/1", sources, count, runs, 1, BATCH_THREADS);
+  snprintf (name, sizeof (name), "threads/%u", threads);
+  bench (name, sources, count, runs, threads, BATCH_THREADS);
+
+  return STATE_OK;
+}
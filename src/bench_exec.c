@@ -0,0 +1,277 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Exec latency harness: run the plugin like a Nagios scheduler does
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Usage: bench_exec [-n RUNS] [-j JOBS] [-m spawn|vfork|shell] [-J]
+ *                   PLUGIN [ARGS...]
+ *
+ * Launches the plugin RUNS times keeping JOBS of them running at once,
+ * and reports the percentiles of the wall time, the average CPU time and
+ * page faults and the peak RSS of the children.  The plugin output is
+ * discarded.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nputils.h"
+
+enum spawn_method
+{
+  METHOD_SPAWN,
+  METHOD_VFORK,
+  METHOD_SHELL
+};
+
+struct run
+{
+  pid_t pid;
+  long long start;
+};
+
+struct sample
+{
+  long long wall_ns;
+  long long cpu_us;
+  long minflt;
+  long majflt;
+  long maxrss_kb;
+};
+
+static long long
+nsecs (void)
+{
+  struct timespec t;
+
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return (long long) t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static int
+cmp_wall (const void *a, const void *b)
+{
+  long long x = ((const struct sample *) a)->wall_ns;
+  long long y = ((const struct sample *) b)->wall_ns;
+
+  return (x > y) - (x < y);
+}
+
+/* Start the plugin with its output redirected to /dev/null */
+static pid_t
+launch (enum spawn_method method, char **argv, char *shell_command,
+	int devnull)
+{
+  posix_spawn_file_actions_t actions;
+  char *shell_argv[] = { (char *) "/bin/sh", (char *) "-c", shell_command,
+    NULL
+  };
+  pid_t pid = -1;
+
+  switch (method)
+    {
+    case METHOD_VFORK:
+      if (0 == (pid = vfork ()))
+	{
+	  dup2 (devnull, STDOUT_FILENO);
+	  execve (argv[0], argv, environ);
+	  _exit (127);
+	}
+      break;
+    case METHOD_SPAWN:
+    case METHOD_SHELL:
+      posix_spawn_file_actions_init (&actions);
+      posix_spawn_file_actions_adddup2 (&actions, devnull, STDOUT_FILENO);
+      if (0 != posix_spawn (&pid, (method == METHOD_SHELL) ?
+			    shell_argv[0] : argv[0], &actions, NULL,
+			    (method == METHOD_SHELL) ? shell_argv : argv,
+			    environ))
+	pid = -1;
+      posix_spawn_file_actions_destroy (&actions);
+      break;
+    }
+
+  return pid;
+}
+
+static double
+percentile (const struct sample *samples, long n, double p)
+{
+  long i = (long) (p * (n - 1) + 0.5);
+
+  return samples[i].wall_ns / 1000.0;
+}
+
+int
+main (int argc, char **argv)
+{
+  enum spawn_method method = METHOD_SPAWN;
+  const char *method_name = "spawn";
+  long runs = 1000, jobs = 1, started = 0, done = 0, i, failures = 0;
+  long maxrss_kb = 0;
+  long long cpu_us = 0, minflt = 0, majflt = 0, total_start;
+  struct sample *samples;
+  struct run *running;
+  struct rusage ru;
+  char *shell_command;
+  size_t len;
+  int c, json_output = FALSE, devnull, wstatus;
+  pid_t pid;
+
+  while ((c = getopt (argc, argv, "+n:j:m:J")) != -1)
+    switch (c)
+      {
+      case 'n':
+	runs = atol (optarg);
+	break;
+      case 'j':
+	jobs = atol (optarg);
+	break;
+      case 'm':
+	method_name = optarg;
+	if (!strcmp (optarg, "spawn"))
+	  method = METHOD_SPAWN;
+	else if (!strcmp (optarg, "vfork"))
+	  method = METHOD_VFORK;
+	else if (!strcmp (optarg, "shell"))
+	  method = METHOD_SHELL;
+	else
+	  runs = 0;
+	break;
+      case 'J':
+	json_output = TRUE;
+	break;
+      default:
+	runs = 0;
+	break;
+      }
+
+  if (optind >= argc || runs <= 0 || jobs <= 0)
+    {
+      fprintf (stderr, "Usage: %s [-n RUNS] [-j JOBS] "
+	       "[-m spawn|vfork|shell] [-J] PLUGIN [ARGS...]\n", argv[0]);
+      return STATE_UNKNOWN;
+    }
+  argv += optind;
+  argc -= optind;
+
+  for (len = 1, i = 0; i < argc; i++)
+    len += strlen (argv[i]) + 1;
+  shell_command = malloc (len);
+  samples = calloc (runs, sizeof (struct sample));
+  running = calloc (jobs, sizeof (struct run));
+  if (NULL == shell_command || NULL == samples || NULL == running)
+    {
+      perror ("cannot allocate memory");
+      return STATE_UNKNOWN;
+    }
+  for (shell_command[0] = '\0', i = 0; i < argc; i++)
+    {
+      strcat (shell_command, argv[i]);
+      if (i < argc - 1)
+	strcat (shell_command, " ");
+    }
+
+  if ((devnull = open ("/dev/null", O_WRONLY)) < 0)
+    {
+      perror ("/dev/null");
+      return STATE_UNKNOWN;
+    }
+
+  total_start = nsecs ();
+  while (done < runs)
+    {
+      for (i = 0; i < jobs && started < runs; i++)
+	if (running[i].pid == 0)
+	  {
+	    running[i].start = nsecs ();
+	    if ((running[i].pid = launch (method, argv, shell_command,
+					  devnull)) < 0)
+	      {
+		perror (argv[0]);
+		return STATE_UNKNOWN;
+	      }
+	    started++;
+	  }
+
+      if ((pid = wait4 (-1, &wstatus, 0, &ru)) < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  perror ("wait4");
+	  return STATE_UNKNOWN;
+	}
+      for (i = 0; i < jobs && running[i].pid != pid; i++)
+	;
+      if (i == jobs)
+	continue;
+
+      samples[done].wall_ns = nsecs () - running[i].start;
+      samples[done].cpu_us =
+	(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000LL +
+	ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+      samples[done].minflt = ru.ru_minflt;
+      samples[done].majflt = ru.ru_majflt;
+      samples[done].maxrss_kb = ru.ru_maxrss;
+      if (!WIFEXITED (wstatus) || WEXITSTATUS (wstatus) > STATE_UNKNOWN)
+	failures++;
+
+      cpu_us += samples[done].cpu_us;
+      minflt += samples[done].minflt;
+      majflt += samples[done].majflt;
+      if (samples[done].maxrss_kb > maxrss_kb)
+	maxrss_kb = samples[done].maxrss_kb;
+
+      running[i].pid = 0;
+      done++;
+    }
+
+  qsort (samples, runs, sizeof (struct sample), cmp_wall);
+
+  printf (json_output ?
+	  "{\"method\": \"%s\", \"runs\": %ld, \"jobs\": %ld, "
+	  "\"failures\": %ld, \"runs_per_sec\": %.1f, "
+	  "\"wall_p50_us\": %.1f, \"wall_p99_us\": %.1f, "
+	  "\"wall_p999_us\": %.1f, \"cpu_avg_us\": %.1f, "
+	  "\"minflt_avg\": %.1f, \"majflt_avg\": %.2f, "
+	  "\"maxrss_peak_kb\": %ld}\n" :
+	  "method\t%s\nruns\t%ld\njobs\t%ld\nfailures\t%ld\n"
+	  "runs_per_sec\t%.1f\nwall_p50_us\t%.1f\nwall_p99_us\t%.1f\n"
+	  "wall_p999_us\t%.1f\ncpu_avg_us\t%.1f\nminflt_avg\t%.1f\n"
+	  "majflt_avg\t%.2f\nmaxrss_peak_kb\t%ld\n",
+	  method_name, runs, jobs, failures,
+	  runs * 1e9 / (nsecs () - total_start),
+	  percentile (samples, runs, 0.50), percentile (samples, runs, 0.99),
+	  percentile (samples, runs, 0.999), (double) cpu_us / runs,
+	  (double) minflt / runs, (double) majflt / runs, maxrss_kb);
+
+  return (failures > 0) ? STATE_CRITICAL : STATE_OK;
+}
@@ -0,0 +1,298 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Stub harness of the Nagios Event Broker module
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Usage: bench_neb [-n CHECKS] [-e EXECS] PLUGIN
+ *
+ * Plays the part of the Nagios core for the module compiled in (with the
+ * stub headers of nebstub/): loads it, then sends it service check events.
+ * First every command line of a table is checked: the module must run it
+ * in-process, with the output and the exit code of the plugin run through
+ * /bin/sh, or leave it to the core.  Then CHECKS checks (1000000 by
+ * default) go through the module and EXECS (2000) are forked, and the
+ * checks per second of both are printed, tab separated.
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NSCORE 1
+#include <nagios/nebmodules.h>
+#include <nagios/nebcallbacks.h>
+#include <nagios/nebstructs.h>
+#include <nagios/broker.h>
+#include <nagios/nagios.h>
+
+#include "nputils.h"
+
+int nebmodule_init (int, char *, nebmodule *);
+int nebmodule_deinit (int, int);
+
+/* the core side */
+
+static int (*service_check_callback) (int, void *);
+static int results;
+static int last_return_code;
+static char last_output[MAX_COMMAND_BUFFER];
+
+int
+neb_register_callback (int callback_type, void *handle
+		       __attribute__ ((__unused__)), int priority
+		       __attribute__ ((__unused__)),
+		       int (*callback) (int, void *))
+{
+  if (callback_type != NEBCALLBACK_SERVICE_CHECK_DATA)
+    return NEB_ERROR;
+  service_check_callback = callback;
+  return NEB_OK;
+}
+
+int
+neb_deregister_callback (int callback_type __attribute__ ((__unused__)),
+			 int (*callback) (int, void *))
+{
+  if (service_check_callback != callback)
+    return NEB_ERROR;
+  service_check_callback = NULL;
+  return NEB_OK;
+}
+
+int
+neb_set_module_info (void *handle __attribute__ ((__unused__)),
+		     int type __attribute__ ((__unused__)),
+		     char *data __attribute__ ((__unused__)))
+{
+  return NEB_OK;
+}
+
+int
+init_check_result (check_result * cr)
+{
+  memset (cr, 0, sizeof (*cr));
+  return 0;
+}
+
+int
+process_check_result (check_result * cr)
+{
+  results++;
+  last_return_code = cr->return_code;
+  snprintf (last_output, sizeof (last_output), "%s", cr->output);
+  return 0;
+}
+
+int
+free_check_result (check_result * cr)
+{
+  free (cr->host_name);
+  free (cr->service_description);
+  free (cr->output);
+  return 0;
+}
+
+void
+logit (int data_type __attribute__ ((__unused__)),
+       int display __attribute__ ((__unused__)), const char *fmt, ...)
+{
+  va_list ap;
+
+  va_start (ap, fmt);
+  vfprintf (stderr, fmt, ap);
+  va_end (ap);
+}
+
+/* the harness */
+
+/* the command lines are 'wrapper' PLUGIN 'args' */
+struct test_case
+{
+  const char *wrapper;
+  const char *args;
+  int in_process;
+};
+
+static const struct test_case test_cases[] = {
+  {"", " -w 30: -c 15:", TRUE},
+  {"", " -w '30:' -c '15:'", TRUE},
+  {"", " --warning=\"@0:10\" --critical 5", TRUE},
+  {"", " -w 30\\: -c \"1\"'5:'", TRUE},
+  {"", " -c ~:10", TRUE},
+  {"", "", TRUE},
+  {"", " -w $ARG1$ -c 15:", FALSE},
+  {"", " -w \"$ARG1$\" -c 15:", FALSE},
+  {"", " -w 30: | tee /dev/null", FALSE},
+  {"", " -w `echo 30:`", FALSE},
+  {"", " -w '30:", FALSE},
+  {"", " --help", FALSE},
+  {"/usr/bin/env ", " -w 30:", FALSE},
+};
+
+#define TEST_CASES  (sizeof (test_cases) / sizeof (test_cases[0]))
+
+static long long
+nsecs (void)
+{
+  struct timespec t;
+
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return (long long) t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+/* Send a service check event.  Returns TRUE if it was run in-process */
+static int
+send_check (char *command_line)
+{
+  nebstruct_service_check_data ds;
+
+  memset (&ds, 0, sizeof (ds));
+  ds.type = NEBTYPE_SERVICECHECK_INITIATE;
+  ds.host_name = (char *) "localhost";
+  ds.service_description = (char *) "Uptime";
+  ds.command_line = command_line;
+
+  return service_check_callback (NEBCALLBACK_SERVICE_CHECK_DATA, &ds)
+    == NEBERROR_CALLBACKOVERRIDE;
+}
+
+/* Run 'command_line' with /bin/sh.  Returns the exit code or -1 */
+static int
+shell_check (const char *command_line, char *output, size_t size)
+{
+  FILE *fp;
+  int status;
+
+  if ((fp = popen (command_line, "r")) == NULL)
+    return -1;
+  if (fgets (output, (int) size, fp) == NULL)
+    output[0] = '\0';
+  output[strcspn (output, "\n")] = '\0';
+  status = pclose (fp);
+
+  return WIFEXITED (status) ? WEXITSTATUS (status) : -1;
+}
+
+int
+main (int argc, char **argv)
+{
+  char command_line[MAX_COMMAND_BUFFER], expected[MAX_COMMAND_BUFFER];
+  char *plugin_argv[6];
+  long checks = 1000000, execs = 2000, i;
+  long long start, neb_ns, exec_ns;
+  posix_spawn_file_actions_t actions;
+  unsigned int t;
+  int c, failures = 0, in_process, code, devnull, wstatus;
+  nebmodule handle;
+  pid_t pid;
+
+  while ((c = getopt (argc, argv, "e:n:")) != -1)
+    switch (c)
+      {
+      case 'e':
+	execs = strtol (optarg, NULL, 10);
+	break;
+      case 'n':
+	checks = strtol (optarg, NULL, 10);
+	break;
+      default:
+	checks = 0;
+	break;
+      }
+
+  if (optind != argc - 1 || checks <= 0 || execs <= 0)
+    {
+      fprintf (stderr, "Usage: %s [-n CHECKS] [-e EXECS] PLUGIN\n", argv[0]);
+      return STATE_UNKNOWN;
+    }
+
+  memset (&handle, 0, sizeof (handle));
+  if (nebmodule_init (0, NULL, &handle) != NEB_OK
+      || service_check_callback == NULL)
+    {
+      fputs ("the module did not register its callback\n", stderr);
+      return STATE_UNKNOWN;
+    }
+
+  for (t = 0; t < TEST_CASES; t++)
+    {
+      snprintf (command_line, sizeof (command_line), "%s%s%s",
+		test_cases[t].wrapper, argv[optind], test_cases[t].args);
+      code = shell_check (command_line, expected, sizeof (expected));
+      results = 0;
+      in_process = send_check (command_line);
+      if (in_process != test_cases[t].in_process
+	  || (in_process && (results != 1 || code != last_return_code
+			     || strcmp (expected, last_output))))
+	{
+	  printf ("FAILED\t%s\n", command_line);
+	  if (in_process)
+	    printf ("\texec:\t%d %s\n\tneb:\t%d %s\n", code, expected,
+		    last_return_code, last_output);
+	  failures++;
+	}
+      else
+	printf ("ok\t%sPLUGIN%s\t%s\n", test_cases[t].wrapper,
+		test_cases[t].args, in_process ? "in-process" : "exec");
+    }
+
+  start = nsecs ();
+  for (i = 0; i < checks; i++)
+    {
+      snprintf (command_line, sizeof (command_line), "%s -w 30: -c 15:",
+		argv[optind]);
+      if (!send_check (command_line))
+	failures++;
+    }
+  neb_ns = nsecs () - start;
+
+  plugin_argv[0] = argv[optind];
+  plugin_argv[1] = (char *) "-w";
+  plugin_argv[2] = (char *) "30:";
+  plugin_argv[3] = (char *) "-c";
+  plugin_argv[4] = (char *) "15:";
+  plugin_argv[5] = NULL;
+  if ((devnull = open ("/dev/null", O_WRONLY)) < 0)
+    return STATE_UNKNOWN;
+  posix_spawn_file_actions_init (&actions);
+  posix_spawn_file_actions_adddup2 (&actions, devnull, STDOUT_FILENO);
+  start = nsecs ();
+  for (i = 0; i < execs; i++)
+    if (posix_spawn (&pid, plugin_argv[0], &actions, NULL, plugin_argv,
+		     environ) != 0 || waitpid (pid, &wstatus, 0) < 0)
+      failures++;
+  exec_ns = nsecs () - start;
+  posix_spawn_file_actions_destroy (&actions);
+
+  nebmodule_deinit (0, 0);
+
+  printf ("# mode\tchecks\tchecks/s\n");
+  printf ("neb\t%ld\t%.0f\n", checks, (double) checks * 1e9 / neb_ns);
+  printf ("exec\t%ld\t%.0f\n", execs, (double) execs * 1e9 / exec_ns);
+
+  return failures ? STATE_CRITICAL : STATE_OK;
+}
@@ -0,0 +1,288 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Loopback replay client of the NRPE server mode
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Usage: bench_nrpe [-n QUERIES] [-j JOBS] [-v 2|3] [-c COMMAND] ADDR:PORT
+ *
+ * Sends QUERIES (10000 by default) NRPE query packets of the given version
+ * (2) for COMMAND ("check_uptime") to the server, one per connection as
+ * the NRPE clients do, from JOBS (1) processes at once.  Every response is
+ * checked (packet type, CRC32 and a Nagios state); prints, tab separated,
+ * the version, the queries, the jobs, the requests per second, the p50 and
+ * p99 latency in microseconds and the number of bad or missing responses.
+ */
+
+#include "config.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nputils.h"
+
+#define NRPE_V2_PACKET_SIZE     1036
+#define NRPE_V3_HEADER_SIZE     16
+#define NRPE_MAX_RESPONSE       (NRPE_V3_HEADER_SIZE + 65536 + 4)
+
+static unsigned long crc32_table[256];
+
+static long long
+nsecs (void)
+{
+  struct timespec t;
+
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return (long long) t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static int
+cmp_ll (const void *a, const void *b)
+{
+  long long x = *(const long long *) a, y = *(const long long *) b;
+
+  return (x > y) - (x < y);
+}
+
+static void
+crc32_init (void)
+{
+  unsigned long crc;
+  int i, j;
+
+  for (i = 0; i < 256; i++)
+    {
+      crc = (unsigned long) i;
+      for (j = 8; j > 0; j--)
+	crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320UL : crc >> 1;
+      crc32_table[i] = crc;
+    }
+}
+
+static unsigned long
+crc32 (const unsigned char *data, size_t len)
+{
+  unsigned long crc = 0xFFFFFFFFUL;
+
+  while (len--)
+    crc = ((crc >> 8) & 0x00FFFFFFUL) ^ crc32_table[(crc ^ *data++) & 0xFF];
+  return crc ^ 0xFFFFFFFFUL;
+}
+
+static void
+put16 (unsigned char *p, unsigned int v)
+{
+  p[0] = (v >> 8) & 0xFF;
+  p[1] = v & 0xFF;
+}
+
+static void
+put32 (unsigned char *p, unsigned long v)
+{
+  p[0] = (v >> 24) & 0xFF;
+  p[1] = (v >> 16) & 0xFF;
+  p[2] = (v >> 8) & 0xFF;
+  p[3] = v & 0xFF;
+}
+
+static unsigned long
+get32 (const unsigned char *p)
+{
+  return ((unsigned long) p[0] << 24) | ((unsigned long) p[1] << 16) |
+    ((unsigned long) p[2] << 8) | p[3];
+}
+
+/* Build the query packet for 'command' in 'packet'.  Returns its size */
+static size_t
+build_query (unsigned char *packet, int version, const char *command)
+{
+  size_t len = strlen (command), size;
+
+  if (version == 2)
+    {
+      size = NRPE_V2_PACKET_SIZE;
+      memset (packet, 0, size);
+      memcpy (packet + 10, command, len);
+    }
+  else
+    {
+      size = NRPE_V3_HEADER_SIZE + len + 1;
+      memset (packet, 0, size);
+      put32 (packet + 12, len + 1);
+      memcpy (packet + NRPE_V3_HEADER_SIZE, command, len);
+    }
+  put16 (packet, (unsigned int) version);
+  put16 (packet + 2, 1);
+  put32 (packet + 4, crc32 (packet, size));
+
+  return size;
+}
+
+/* Returns TRUE if 'data' is a valid response packet */
+static int
+check_response (unsigned char *data, size_t len, int version)
+{
+  unsigned long crc;
+  unsigned int state;
+
+  if (len < NRPE_V3_HEADER_SIZE || data[1] != version || data[3] != 2)
+    return FALSE;
+  if (version == 2 && len != NRPE_V2_PACKET_SIZE)
+    return FALSE;
+
+  crc = get32 (data + 4);
+  put32 (data + 4, 0);
+  state = ((unsigned int) data[8] << 8) | data[9];
+
+  return crc == crc32 (data, len) && state <= STATE_UNKNOWN;
+}
+
+/* Send one query on a new connection.  Returns the latency or -1 */
+static long long
+query (const struct sockaddr_in *addr, const unsigned char *packet,
+       size_t size, int version, unsigned char *response)
+{
+  long long start = nsecs ();
+  size_t len = 0;
+  ssize_t n;
+  int fd;
+
+  if ((fd = socket (AF_INET, SOCK_STREAM, 0)) < 0)
+    return -1;
+  if (connect (fd, (const struct sockaddr *) addr, sizeof (*addr)) < 0
+      || write (fd, packet, size) != (ssize_t) size)
+    {
+      close (fd);
+      return -1;
+    }
+  while (len < NRPE_MAX_RESPONSE
+	 && (n = read (fd, response + len, NRPE_MAX_RESPONSE - len)) > 0)
+    len += (size_t) n;
+  close (fd);
+
+  if (!check_response (response, len, version))
+    return -1;
+
+  return nsecs () - start;
+}
+
+int
+main (int argc, char **argv)
+{
+  const char *command = "check_uptime";
+  unsigned char packet[NRPE_V2_PACKET_SIZE + 1024], *response;
+  long queries = 10000, jobs = 1, i, j, errors = 0;
+  long long *latencies, start, elapsed;
+  struct sockaddr_in addr;
+  int c, version = 2, status;
+  size_t size;
+  char *port;
+
+  while ((c = getopt (argc, argv, "c:j:n:v:")) != -1)
+    switch (c)
+      {
+      case 'c':
+	command = optarg;
+	break;
+      case 'j':
+	jobs = strtol (optarg, NULL, 10);
+	break;
+      case 'n':
+	queries = strtol (optarg, NULL, 10);
+	break;
+      case 'v':
+	version = atoi (optarg);
+	break;
+      default:
+	queries = 0;
+	break;
+      }
+
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  port = (optind == argc - 1) ? strrchr (argv[optind], ':') : NULL;
+  if (port)
+    *port++ = '\0';
+  if (port == NULL || inet_pton (AF_INET, argv[optind], &addr.sin_addr) != 1
+      || queries <= 0 || jobs <= 0 || jobs > queries
+      || (version != 2 && version != 3) || strlen (command) >= 1024)
+    {
+      fprintf (stderr, "Usage: %s [-n QUERIES] [-j JOBS] [-v 2|3] "
+	       "[-c COMMAND] ADDR:PORT\n", argv[0]);
+      return STATE_UNKNOWN;
+    }
+  addr.sin_port = htons ((unsigned short) atoi (port));
+
+  crc32_init ();
+  size = build_query (packet, version, command);
+
+  /* the children write their latencies in a shared array */
+  latencies = mmap (NULL, (size_t) queries * sizeof (*latencies),
+		    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  response = malloc (NRPE_MAX_RESPONSE);
+  if (latencies == MAP_FAILED || response == NULL)
+    {
+      perror ("bench_nrpe");
+      return STATE_UNKNOWN;
+    }
+
+  start = nsecs ();
+  for (j = 0; j < jobs; j++)
+    {
+      pid_t pid = fork ();
+
+      if (pid < 0)
+	{
+	  perror ("fork");
+	  return STATE_UNKNOWN;
+	}
+      if (pid == 0)
+	{
+	  for (i = j; i < queries; i += jobs)
+	    latencies[i] = query (&addr, packet, size, version, response);
+	  _exit (0);
+	}
+    }
+  while (wait (&status) > 0 || errno == EINTR)
+    ;
+  elapsed = nsecs () - start;
+
+  for (i = j = 0; i < queries; i++)
+    if (latencies[i] < 0)
+      errors++;
+    else
+      latencies[j++] = latencies[i];
+  qsort (latencies, (size_t) j, sizeof (*latencies), cmp_ll);
+
+  printf ("# version\tqueries\tjobs\treq/s\tp50_us\tp99_us\terrors\n");
+  printf ("v%d\t%ld\t%ld\t%.0f\t%.1f\t%.1f\t%ld\n", version, queries, jobs,
+	  (double) queries * 1e9 / (double) elapsed,
+	  j ? (double) latencies[(j - 1) / 2] / 1000.0 : 0.0,
+	  j ? (double) latencies[(j - 1) * 99 / 100] / 1000.0 : 0.0, errors);
+
+  return errors ? STATE_CRITICAL : STATE_OK;
+}
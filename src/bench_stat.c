@@ -0,0 +1,147 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Benchmark of the /proc/stat parser
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Usage: bench_stat [-r RUNS] FILE...
+ *
+ * Reads the cpu lines of every /proc/stat FILE (captured on a large
+ * machine, or written by gen_procstat) RUNS times (1000 by default) with
+ * cpustat_read() and with the usual fgets() and sscanf() loop, and prints,
+ * tab separated, the file, its CPUs and bytes and the microseconds per
+ * read of both, and fails if cpustat_read() does not find as many cpu
+ * lines as the stdio loop.
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cpustat.h"
+#include "nputils.h"
+
+static volatile unsigned long long sink;
+
+static long long
+nsecs (void)
+{
+  struct timespec t;
+
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return (long long) t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+/* The parser being replaced: stdio, a line at a time */
+static int
+stdio_read (const char *path)
+{
+  char line[256];
+  unsigned long long user, nice, sys, idle, iowait;
+  int cpus = 0, id;
+  FILE *fp;
+
+  if ((fp = fopen (path, "r")) == NULL)
+    return -1;
+  while (fgets (line, sizeof (line), fp))
+    {
+      if (strncmp (line, "cpu", 3) != 0)
+	continue;
+      if (sscanf (line, "cpu%d %llu %llu %llu %llu %llu", &id, &user, &nice,
+		  &sys, &idle, &iowait) == 6)
+	sink += idle + iowait;
+      cpus++;
+    }
+  fclose (fp);
+
+  return cpus;
+}
+
+int
+main (int argc, char **argv)
+{
+  struct cpustat_cpu *cpus = NULL;
+  size_t size = 0, ncpus = 0;
+  char *buf = NULL;
+  unsigned long runs = 1000, r;
+  long long t_pread, t_stdio;
+  struct stat st;
+  int c, i, fd, n = 0, expected = 0, status = STATE_OK;
+
+  while ((c = getopt (argc, argv, "r:")) != -1)
+    switch (c)
+      {
+      case 'r':
+	runs = strtoul (optarg, NULL, 10);
+	break;
+      default:
+	runs = 0;
+	break;
+      }
+
+  if (optind == argc || runs == 0)
+    {
+      fprintf (stderr, "Usage: %s [-r RUNS] FILE...\n", argv[0]);
+      return STATE_UNKNOWN;
+    }
+
+  printf ("# file\tcpus\tbytes\tpread_us\tstdio_us\n");
+  for (i = optind; i < argc; i++)
+    {
+      if ((fd = open (argv[i], O_RDONLY | O_CLOEXEC)) < 0
+	  || fstat (fd, &st) < 0)
+	{
+	  perror (argv[i]);
+	  return STATE_UNKNOWN;
+	}
+
+      t_pread = nsecs ();
+      for (r = 0; r < runs; r++)
+	if ((n = cpustat_read (fd, &buf, &size, &cpus, &ncpus)) < 0)
+	  break;
+      t_pread = nsecs () - t_pread;
+      close (fd);
+
+      t_stdio = nsecs ();
+      for (r = 0; r < runs; r++)
+	if ((expected = stdio_read (argv[i])) < 0)
+	  break;
+      t_stdio = nsecs () - t_stdio;
+
+      printf ("%s\t%d\t%lld\t%.2f\t%.2f\n", argv[i], n - 1,
+	      (long long) st.st_size, (double) t_pread / runs / 1000.0,
+	      (double) t_stdio / runs / 1000.0);
+      if (n != expected)
+	{
+	  fprintf (stderr, "%s: %d cpu lines read, %d expected\n", argv[i], n,
+		   expected);
+	  status = STATE_CRITICAL;
+	}
+    }
+
+  free (buf);
+  free (cpus);
+
+  return status;
+}
@@ -0,0 +1,145 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Steady-state CPU cost of the resident textfile writer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Usage: bench_textfile [-n RUNS] [-s SECONDS] PLUGIN DIR
+ *
+ * Runs 'PLUGIN --textfile DIR' RUNS times (100 by default), as a cron job
+ * would, then 'PLUGIN --textfile DIR --interval 1' for SECONDS (30), and
+ * reports the CPU time of a one-shot run and the CPU time per interval of
+ * the resident writer, its startup (estimated by a one-shot run) left
+ * out, with the number of times the file was replaced.
+ */
+
+#include "config.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nputils.h"
+
+static long long
+cpu_usecs (const struct rusage *ru)
+{
+  return (long long) (ru->ru_utime.tv_sec + ru->ru_stime.tv_sec) * 1000000LL
+    + ru->ru_utime.tv_usec + ru->ru_stime.tv_usec;
+}
+
+static pid_t
+start_plugin (char *plugin, char *dir, int resident)
+{
+  char *argv[] = { plugin, (char *) "--textfile", dir, (char *) "--interval",
+    (char *) "1", NULL
+  };
+  pid_t pid;
+
+  if (!resident)
+    argv[3] = NULL;
+  if ((pid = fork ()) == 0)
+    {
+      execv (plugin, argv);
+      _exit (127);
+    }
+
+  return pid;
+}
+
+int
+main (int argc, char **argv)
+{
+  long runs = 100, seconds = 30, i, replaced = 0;
+  long long oneshot_us = 0, resident_us;
+  struct rusage ru;
+  struct stat st;
+  ino_t inode = 0;
+  char path[4096];
+  int c, status;
+  pid_t pid;
+
+  while ((c = getopt (argc, argv, "n:s:")) != -1)
+    switch (c)
+      {
+      case 'n':
+	runs = strtol (optarg, NULL, 10);
+	break;
+      case 's':
+	seconds = strtol (optarg, NULL, 10);
+	break;
+      default:
+	runs = 0;
+	break;
+      }
+
+  if (optind != argc - 2 || runs <= 0 || seconds < 2)
+    {
+      fprintf (stderr, "Usage: %s [-n RUNS] [-s SECONDS] PLUGIN DIR\n",
+	       argv[0]);
+      return STATE_UNKNOWN;
+    }
+  snprintf (path, sizeof (path), "%s/uptime.prom", argv[optind + 1]);
+
+  for (i = 0; i < runs; i++)
+    {
+      if ((pid = start_plugin (argv[optind], argv[optind + 1], FALSE)) < 0
+	  || wait4 (pid, &status, 0, &ru) < 0 || !WIFEXITED (status)
+	  || WEXITSTATUS (status) != STATE_OK)
+	{
+	  fprintf (stderr, "%s: the one-shot run failed\n", argv[optind]);
+	  return STATE_UNKNOWN;
+	}
+      oneshot_us += cpu_usecs (&ru);
+    }
+  oneshot_us /= runs;
+
+  /* count the renames of the file by its inode, ten times per interval */
+  unlink (path);
+  if ((pid = start_plugin (argv[optind], argv[optind + 1], TRUE)) < 0)
+    return STATE_UNKNOWN;
+  for (i = 0; i < seconds * 10; i++)
+    {
+      usleep (100000);
+      if (stat (path, &st) == 0 && st.st_ino != inode)
+	{
+	  inode = st.st_ino;
+	  replaced++;
+	}
+    }
+  kill (pid, SIGTERM);
+  if (wait4 (pid, &status, 0, &ru) < 0)
+    return STATE_UNKNOWN;
+  resident_us = cpu_usecs (&ru);
+
+  printf ("# mode\tintervals\tcpu_us\tcpu_us/interval\treplaced\n");
+  printf ("oneshot\t1\t%lld\t%lld\t1\n", oneshot_us, oneshot_us);
+  printf ("resident\t%ld\t%lld\t%.1f\t%ld\n", seconds, resident_us,
+	  (double) (resident_us - oneshot_us) / (double) (seconds - 1),
+	  replaced);
+
+  return STATE_OK;
+}
@@ -0,0 +1,261 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Benchmark of the thresholds evaluation against the former check_range()
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Usage: bench_thresholds [-n SAMPLES] [-r RUNS]
+ *
+ * Evaluates SAMPLES random values (1000000 by default) against the same
+ * warning and critical range, for every range shape, with the check_range()
+ * of the versions up to 7 (copied below: heap allocated ranges, infinity
+ * flags and four branches), with get_status() value by value and with
+ * get_status_batch().  Prints, tab separated, the shape, the median
+ * nanoseconds per value of each of them over RUNS runs (11) and the
+ * speedup of get_status_batch(); fails if they disagree on any state.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nputils.h"
+
+/* the ranges and check_range() of the versions up to 7 */
+
+typedef struct legacy_range
+{
+  double start;
+  int start_infinity;
+  double end;
+  int end_infinity;
+  int alert_on;
+} legacy_range;
+
+typedef struct legacy_thresholds
+{
+  legacy_range *warning;
+  legacy_range *critical;
+} legacy_thresholds;
+
+static int
+legacy_check_range (double value, legacy_range * my_range)
+{
+  int no = FALSE;
+  int yes = TRUE;
+
+  if (my_range->alert_on == INSIDE)
+    {
+      no = TRUE;
+      yes = FALSE;
+    }
+
+  if (my_range->end_infinity == FALSE && my_range->start_infinity == FALSE)
+    {
+      if ((my_range->start <= value) && (value <= my_range->end))
+	return no;
+      else
+	return yes;
+    }
+  else if (my_range->start_infinity == FALSE
+	   && my_range->end_infinity == TRUE)
+    {
+      if (my_range->start <= value)
+	return no;
+      else
+	return yes;
+    }
+  else if (my_range->start_infinity == TRUE
+	   && my_range->end_infinity == FALSE)
+    {
+      if (value <= my_range->end)
+	return no;
+      else
+	return yes;
+    }
+  else
+    return no;
+}
+
+static int
+legacy_get_status (double value, legacy_thresholds * my_thresholds)
+{
+  if (my_thresholds->critical != NULL)
+    {
+      if (legacy_check_range (value, my_thresholds->critical) == TRUE)
+	return STATE_CRITICAL;
+    }
+  if (my_thresholds->warning != NULL)
+    {
+      if (legacy_check_range (value, my_thresholds->warning) == TRUE)
+	return STATE_WARNING;
+    }
+  return STATE_OK;
+}
+
+/* Convert 'r' to a heap allocated legacy range */
+static legacy_range *
+legacy_range_new (const range * r)
+{
+  legacy_range *l = malloc (sizeof (*l));
+
+  if (l == NULL)
+    return NULL;
+  l->start_infinity = (r->start == -HUGE_VAL);
+  l->start = l->start_infinity ? 0 : r->start;
+  l->end_infinity = (r->end == HUGE_VAL);
+  l->end = l->end_infinity ? 0 : r->end;
+  l->alert_on = r->alert_on;
+
+  return l;
+}
+
+/* warning and critical range of each shape */
+static const char *const range_shapes[][2] = {
+  {"10", "20"},			/* 0 .. N */
+  {"10:", "5:"},		/* N .. +inf */
+  {"~:10", "~:20"},		/* -inf .. N */
+  {"10:20", "5:30"},		/* N .. M */
+  {"@10:20", "@12:18"},		/* alert inside N .. M */
+  {"@~:10", "@~:0"},		/* alert inside -inf .. N */
+};
+
+#define RANGE_SHAPES  (sizeof (range_shapes) / sizeof (range_shapes[0]))
+
+static long long
+nsecs (void)
+{
+  struct timespec t;
+
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return (long long) t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static int
+cmp_ll (const void *a, const void *b)
+{
+  long long x = *(const long long *) a, y = *(const long long *) b;
+
+  return (x > y) - (x < y);
+}
+
+int
+main (int argc, char **argv)
+{
+  long samples = 1000000, i;
+  long long *t[3];
+  unsigned int runs = 11, r, shape, k;
+  double *values, ns[3];
+  int *expected, *status, c, failed = FALSE;
+  volatile int sink = 0;
+  legacy_thresholds legacy;
+  thresholds thr;
+
+  while ((c = getopt (argc, argv, "n:r:")) != -1)
+    switch (c)
+      {
+      case 'n':
+	samples = strtol (optarg, NULL, 10);
+	break;
+      case 'r':
+	runs = (unsigned int) strtoul (optarg, NULL, 10);
+	break;
+      default:
+	samples = 0;
+	break;
+      }
+
+  if (optind != argc || samples <= 0 || runs == 0)
+    {
+      fprintf (stderr, "Usage: %s [-n SAMPLES] [-r RUNS]\n", argv[0]);
+      return STATE_UNKNOWN;
+    }
+
+  values = malloc ((size_t) samples * sizeof (*values));
+  expected = malloc ((size_t) samples * sizeof (*expected));
+  status = malloc ((size_t) samples * sizeof (*status));
+  for (k = 0; k < 3; k++)
+    t[k] = malloc (runs * sizeof (*t[k]));
+  if (!values || !expected || !status || !t[0] || !t[1] || !t[2])
+    {
+      perror ("bench_thresholds");
+      return STATE_UNKNOWN;
+    }
+
+  /* random values defeat the branch predictor of the former code */
+  srand (1);
+  for (i = 0; i < samples; i++)
+    values[i] = (double) (rand () % 6000) / 100.0 - 15.0;
+
+  printf ("# shape\tcheck_range_v7\tget_status\tget_status_batch"
+	  "\tspeedup\n");
+  for (shape = 0; shape < RANGE_SHAPES; shape++)
+    {
+      if (set_thresholds (&thr, range_shapes[shape][0],
+			  range_shapes[shape][1]) != 0
+	  || (legacy.warning = legacy_range_new (&thr.warning)) == NULL
+	  || (legacy.critical = legacy_range_new (&thr.critical)) == NULL)
+	return STATE_UNKNOWN;
+
+      for (r = 0; r < runs; r++)
+	{
+	  t[0][r] = nsecs ();
+	  for (i = 0; i < samples; i++)
+	    expected[i] = legacy_get_status (values[i], &legacy);
+	  t[0][r] = nsecs () - t[0][r];
+
+	  t[1][r] = nsecs ();
+	  for (i = 0; i < samples; i++)
+	    status[i] = get_status (values[i], &thr);
+	  t[1][r] = nsecs () - t[1][r];
+	  if (memcmp (status, expected, (size_t) samples * sizeof (*status)))
+	    failed = TRUE;
+
+	  t[2][r] = nsecs ();
+	  get_status_batch (values, status, (size_t) samples, &thr);
+	  t[2][r] = nsecs () - t[2][r];
+	  if (memcmp (status, expected, (size_t) samples * sizeof (*status)))
+	    failed = TRUE;
+	  sink += status[samples - 1];
+	}
+
+      for (k = 0; k < 3; k++)
+	{
+	  qsort (t[k], runs, sizeof (*t[k]), cmp_ll);
+	  ns[k] = (double) t[k][runs / 2] / (double) samples;
+	}
+      printf ("%s/%s\t%.2f\t%.2f\t%.2f\t%.1fx\n", range_shapes[shape][0],
+	      range_shapes[shape][1], ns[0], ns[1], ns[2], ns[0] / ns[2]);
+
+      free (legacy.warning);
+      free (legacy.critical);
+    }
+
+  if (failed)
+    {
+      fprintf (stderr, "the states differ from the former check_range()\n");
+      return STATE_CRITICAL;
+    }
+
+  return STATE_OK;
+}
@@ -0,0 +1,403 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Microbenchmarks of the hot functions of check_uptime ('make bench')
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Every benchmark prints one line with its name, the nanoseconds, the
+ * instructions (when perf events are available, or -1) and the memory
+ * allocations (with glibc, or -1) per operation, tab separated, or a JSON
+ * object per line with -j.  The thresholds are evaluated once per range
+ * shape, as 'get_status/10:20' for instance.  -f FILTER only runs the
+ * benchmarks whose name contains FILTER.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if HAVE_SYS_SYSINFO_H
+#include <sys/sysinfo.h>
+#endif
+
+#if HAVE_LINUX_PERF_EVENT_H
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include "nputils.h"
+#include "uptime.h"
+
+#define BENCH_MIN_NSECS  200000000LL	/* run each benchmark 0.2s */
+#define BENCH_BATCH      1024
+
+typedef void (*bench_fn) (long);
+
+static volatile long sink;
+static int json_output = FALSE;
+static const char *filter = NULL;
+
+#if defined(__GLIBC__)
+/* count the allocations by interposing the glibc allocator */
+extern void *__libc_malloc (size_t);
+extern void *__libc_calloc (size_t, size_t);
+extern void *__libc_realloc (void *, size_t);
+
+static unsigned long allocations;
+
+void *
+malloc (size_t size)
+{
+  allocations++;
+  return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+  allocations++;
+  return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+  allocations++;
+  return __libc_realloc (ptr, size);
+}
+# define ALLOCATIONS()  ((long) allocations)
+#else
+# define ALLOCATIONS()  (-1L)
+#endif
+
+static long long
+nsecs (void)
+{
+  struct timespec t;
+
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return (long long) t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static int perf_fd = -1;
+
+static void
+perf_open (void)
+{
+#if HAVE_LINUX_PERF_EVENT_H
+  struct perf_event_attr attr;
+
+  memset (&attr, 0, sizeof (attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof (attr);
+  attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  perf_fd = syscall (__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+}
+
+static void
+perf_start (void)
+{
+#if HAVE_LINUX_PERF_EVENT_H
+  if (perf_fd >= 0)
+    {
+      ioctl (perf_fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl (perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+static long long
+perf_stop (void)
+{
+  long long count = -1;
+
+#if HAVE_LINUX_PERF_EVENT_H
+  if (perf_fd >= 0)
+    {
+      ioctl (perf_fd, PERF_EVENT_IOC_DISABLE, 0);
+      if (read (perf_fd, &count, sizeof (count)) != sizeof (count))
+	count = -1;
+    }
+#endif
+
+  return count;
+}
+
+/* Run 'fn' until BENCH_MIN_NSECS are elapsed and print the results */
+static void
+bench (const char *name, bench_fn fn)
+{
+  long long start, elapsed, insns;
+  long iterations = BENCH_BATCH, allocs;
+
+  if (filter && !strstr (name, filter))
+    return;
+
+  fn (BENCH_BATCH);		/* warm up */
+  for (;;)
+    {
+      allocs = ALLOCATIONS ();
+      perf_start ();
+      start = nsecs ();
+      fn (iterations);
+      elapsed = nsecs () - start;
+      insns = perf_stop ();
+      allocs = ALLOCATIONS () - allocs;
+      if (elapsed >= BENCH_MIN_NSECS)
+	break;
+      iterations *= (elapsed > 0 && BENCH_MIN_NSECS / elapsed < 100) ?
+	BENCH_MIN_NSECS / elapsed + 1 : 100;
+    }
+
+  if (json_output)
+    printf ("{\"name\": \"%s\", \"ns_per_op\": %.2f, "
+	    "\"insns_per_op\": %.1f, \"allocs_per_op\": %.3f}\n",
+	    name, (double) elapsed / iterations,
+	    insns < 0 ? -1.0 : (double) insns / iterations,
+	    allocs < 0 ? -1.0 : (double) allocs / iterations);
+  else
+    printf ("%-32s\t%.2f\t%.1f\t%.3f\n", name,
+	    (double) elapsed / iterations,
+	    insns < 0 ? -1.0 : (double) insns / iterations,
+	    allocs < 0 ? -1.0 : (double) allocs / iterations);
+  fflush (stdout);
+}
+
+/* uptime sources */
+
+static void
+bench_uptime (long n)
+{
+  while (n--)
+    sink += uptime ();
+}
+
+#if defined(HAVE_STRUCT_SYSINFO_WITH_UPTIME)
+static void
+bench_sysinfo (long n)
+{
+  struct sysinfo info;
+
+  while (n--)
+    {
+      sysinfo (&info);
+      sink += info.uptime;
+    }
+}
+#endif
+
+#define BENCH_CLOCK(fn, clock_id) \
+static void \
+fn (long n) \
+{ \
+  struct timespec t; \
+  while (n--) \
+    { \
+      clock_gettime (clock_id, &t); \
+      sink += t.tv_sec; \
+    } \
+}
+
+#if defined(HAVE_CLOCK_GETTIME_MONOTONIC)
+BENCH_CLOCK (bench_clock_monotonic, CLOCK_MONOTONIC)
+#endif
+#if defined(CLOCK_MONOTONIC_COARSE)
+BENCH_CLOCK (bench_clock_monotonic_coarse, CLOCK_MONOTONIC_COARSE)
+#endif
+#if defined(CLOCK_BOOTTIME)
+BENCH_CLOCK (bench_clock_boottime, CLOCK_BOOTTIME)
+#endif
+
+/* thresholds */
+
+static const char *const range_shapes[] = {
+  "10",				/* 0 .. 10 */
+  "10:",			/* 10 .. +inf */
+  "~:10",			/* -inf .. 10 */
+  "10:20",			/* 10 .. 20 */
+  "@10:20",			/* alert inside 10 .. 20 */
+  "@~:10",			/* alert inside -inf .. 10 */
+};
+
+#define RANGE_SHAPES  (sizeof (range_shapes) / sizeof (range_shapes[0]))
+
+static void
+bench_parse_range_string (long n)
+{
+  range r;
+
+  while (n--)
+    sink += parse_range_string (&r, range_shapes[n % RANGE_SHAPES]);
+}
+
+static void
+bench_set_thresholds (long n)
+{
+  thresholds t;
+
+  while (n--)
+    sink += set_thresholds (&t, "30:", "@10:15");
+}
+
+static thresholds shape_thresholds[RANGE_SHAPES];
+static unsigned int bench_shape;	/* the shape being benchmarked */
+static double values[BENCH_BATCH];
+static int statuses[BENCH_BATCH];
+
+static void
+bench_check_range (long n)
+{
+  long i;
+
+  while (n > 0)
+    {
+      for (i = 0; i < BENCH_BATCH && i < n; i++)
+	sink += check_range (values[i],
+			     &shape_thresholds[bench_shape].critical);
+      n -= i;
+    }
+}
+
+static void
+bench_get_status (long n)
+{
+  long i;
+
+  while (n > 0)
+    {
+      for (i = 0; i < BENCH_BATCH && i < n; i++)
+	sink += get_status (values[i], &shape_thresholds[bench_shape]);
+      n -= i;
+    }
+}
+
+static void
+bench_get_status_batch (long n)
+{
+  long i;
+
+  while (n > 0)
+    {
+      i = (n < BENCH_BATCH) ? n : BENCH_BATCH;
+      get_status_batch (values, statuses, i, &shape_thresholds[bench_shape]);
+      sink += statuses[i - 1];
+      n -= i;
+    }
+}
+
+/* run once per range shape */
+static const struct
+{
+  const char *name;
+  bench_fn fn;
+} threshold_benches[] = {
+  {"check_range", bench_check_range},
+  {"get_status", bench_get_status},
+  {"get_status_batch", bench_get_status_batch},
+};
+
+#define THRESHOLD_BENCHES \
+  (sizeof (threshold_benches) / sizeof (threshold_benches[0]))
+
+/* formatting */
+
+static void
+bench_sprint_uptime (long n)
+{
+  char buf[128];
+
+  while (n--)
+    sink += sprint_uptime (buf, sizeof (buf), 86400 * 3 + 3600 * 5 + n)[0];
+}
+
+static void
+bench_sprint_check_result (long n)
+{
+  char line[128];
+
+  while (n--)
+    sink += sprint_check_result (line, sizeof (line), 86400 * 3 + n,
+				 &shape_thresholds[0]);
+}
+
+int
+main (int argc, char **argv)
+{
+  unsigned int i;
+  char name[64];
+  int c;
+
+  while ((c = getopt (argc, argv, "jf:")) != -1)
+    switch (c)
+      {
+      case 'j':
+	json_output = TRUE;
+	break;
+      case 'f':
+	filter = optarg;
+	break;
+      default:
+	fprintf (stderr, "Usage: %s [-j] [-f FILTER]\n", argv[0]);
+	return STATE_UNKNOWN;
+      }
+
+  for (i = 0; i < RANGE_SHAPES; i++)
+    set_thresholds (&shape_thresholds[i], range_shapes[i], range_shapes[i]);
+  for (i = 0; i < BENCH_BATCH; i++)
+    values[i] = (double) (i % 40) - 5;
+
+  perf_open ();
+  if (!json_output)
+    printf ("# name\tns/op\tinsns/op\tallocs/op\n");
+
+  bench ("uptime", bench_uptime);
+#if defined(HAVE_STRUCT_SYSINFO_WITH_UPTIME)
+  bench ("uptime/sysinfo", bench_sysinfo);
+#endif
+#if defined(HAVE_CLOCK_GETTIME_MONOTONIC)
+  bench ("uptime/clock_monotonic", bench_clock_monotonic);
+#endif
+#if defined(CLOCK_MONOTONIC_COARSE)
+  bench ("uptime/clock_monotonic_coarse", bench_clock_monotonic_coarse);
+#endif
+#if defined(CLOCK_BOOTTIME)
+  bench ("uptime/clock_boottime", bench_clock_boottime);
+#endif
+  bench ("parse_range_string", bench_parse_range_string);
+  bench ("set_thresholds", bench_set_thresholds);
+  for (i = 0; i < THRESHOLD_BENCHES; i++)
+    for (bench_shape = 0; bench_shape < RANGE_SHAPES; bench_shape++)
+      {
+	snprintf (name, sizeof (name), "%s/%s", threshold_benches[i].name,
+		  range_shapes[bench_shape]);
+	bench (name, threshold_benches[i].fn);
+      }
+  bench ("sprint_uptime", bench_sprint_uptime);
+  bench ("sprint_check_result", bench_sprint_check_result);
+
+  return STATE_OK;
+}
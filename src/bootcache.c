@@ -0,0 +1,218 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Cache of the boot time keyed by the kernel boot identifier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The boot time only changes at reboots, so with a costly uptime source
+ * (kstat, perfstat) it is cheaper to store it once in a small file and
+ * then compute the uptime from the wall clock.  The cache is discarded
+ * when:
+ *  - the boot identifier (on Linux the random boot_id generated by the
+ *    kernel at each boot) differs from the stored one;
+ *  - the monotonic clock is lower than the stored one (a reboot on the
+ *    platforms without a boot identifier);
+ *  - the wall clock and the monotonic clock did not advance by the same
+ *    amount since the cache was written (the wall clock was stepped).
+ * The file is read once per process, written without stdio and replaced
+ * atomically.  Not thread-safe.
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bootcache.h"
+#include "nputils.h"
+#include "uptime.h"
+
+#define BOOTCACHE_MAGIC    0x55504243UL	/* "UPBC" */
+#define BOOTCACHE_VERSION  1
+#define BOOTCACHE_ID_SIZE  64
+
+/* maximal difference, in seconds, between the two clocks */
+#define BOOTCACHE_MAX_DRIFT  2
+
+#if defined(HAVE_CLOCK_GETTIME_MONOTONIC) && defined(CLOCK_BOOTTIME)
+#define BOOTCACHE_CLOCK  CLOCK_BOOTTIME	/* also counts the suspend time */
+#elif defined(HAVE_CLOCK_GETTIME_MONOTONIC)
+#define BOOTCACHE_CLOCK  CLOCK_MONOTONIC
+#endif
+
+struct bootcache_record
+{
+  uint32_t magic;
+  uint32_t version;
+  char boot_id[BOOTCACHE_ID_SIZE];
+  int64_t boot_time;		/* seconds since the epoch */
+  int64_t wall_ref;		/* wall clock when the record was written */
+  int64_t mono_ref;		/* BOOTCACHE_CLOCK at the same time */
+};
+
+static const char *cache_path;
+static const char *boot_id_path = BOOTCACHE_BOOT_ID;
+static struct bootcache_record cache;
+static int cache_loaded;
+
+/*
+ * Enable the cache stored in 'path', using the boot identifier read from
+ * 'id_path' (the Linux boot_id if NULL).  Returns -1 if the platform lacks
+ * a monotonic clock.
+ */
+int
+bootcache_init (const char *path, const char *id_path)
+{
+#if defined(BOOTCACHE_CLOCK)
+  cache_path = path;
+  if (id_path)
+    boot_id_path = id_path;
+  cache_loaded = FALSE;
+  return 0;
+#else
+  (void) path;
+  (void) id_path;
+  return -1;
+#endif
+}
+
+int
+bootcache_enabled (void)
+{
+  return cache_path != NULL;
+}
+
+#if defined(BOOTCACHE_CLOCK)
+/* Read the boot identifier, an empty string if there is none */
+static void
+read_boot_id (char *id)
+{
+  ssize_t len;
+  int fd;
+
+  memset (id, 0, BOOTCACHE_ID_SIZE);
+  if ((fd = open (boot_id_path, O_RDONLY | O_CLOEXEC)) < 0)
+    return;
+  len = read (fd, id, BOOTCACHE_ID_SIZE - 1);
+  close (fd);
+
+  while (len > 0 && (id[len - 1] == '\n' || id[len - 1] == '\0'))
+    len--;
+  memset (id + (len > 0 ? len : 0), 0,
+	  BOOTCACHE_ID_SIZE - (len > 0 ? len : 0));
+}
+
+static int
+load_cache (void)
+{
+  ssize_t len;
+  int fd;
+
+  if ((fd = open (cache_path, O_RDONLY | O_CLOEXEC)) < 0)
+    return -1;
+  len = read (fd, &cache, sizeof (cache));
+  close (fd);
+
+  if (len != sizeof (cache) || cache.magic != BOOTCACHE_MAGIC
+      || cache.version != BOOTCACHE_VERSION)
+    return -1;
+
+  return 0;
+}
+
+static void
+store_cache (void)
+{
+  char tmp[PATH_MAX];
+  size_t len = strlen (cache_path);
+  int fd;
+
+  if (len + sizeof (".XXXXXX") > sizeof (tmp))
+    return;
+  memcpy (tmp, cache_path, len);
+  memcpy (tmp + len, ".XXXXXX", sizeof (".XXXXXX"));
+
+  if ((fd = mkstemp (tmp)) < 0)
+    return;
+  if (fchmod (fd, 0644) < 0
+      || write (fd, &cache, sizeof (cache)) != sizeof (cache)
+      || close (fd) < 0 || rename (tmp, cache_path) < 0)
+    unlink (tmp);
+}
+#endif
+
+/*
+ * Return the uptime computed from the cached boot time, refreshing the
+ * cache with the value returned by 'source' when it is not valid.
+ */
+time_t
+bootcache_uptime (time_t (*source) (void))
+{
+#if defined(BOOTCACHE_CLOCK)
+  char boot_id[BOOTCACHE_ID_SIZE];
+  struct timespec mono;
+  time_t now, secs;
+  int64_t drift;
+
+  if (0 != clock_gettime (BOOTCACHE_CLOCK, &mono))
+    return source ();
+  now = time (NULL);
+
+  if (!cache_loaded)
+    {
+      read_boot_id (boot_id);
+      cache_loaded = (0 == load_cache ()
+		      && 0 == memcmp (cache.boot_id, boot_id,
+				      BOOTCACHE_ID_SIZE));
+    }
+  else
+    memcpy (boot_id, cache.boot_id, BOOTCACHE_ID_SIZE);
+
+  if (cache_loaded && mono.tv_sec >= cache.mono_ref)
+    {
+      drift = (now - cache.wall_ref) - (mono.tv_sec - cache.mono_ref);
+      if (drift >= -BOOTCACHE_MAX_DRIFT && drift <= BOOTCACHE_MAX_DRIFT)
+	return (time_t) (now - cache.boot_time);
+    }
+
+  /* no cache, reboot or wall clock step */
+  if (UPTIME_RET_FAIL == (secs = source ()))
+    return UPTIME_RET_FAIL;
+
+  memset (&cache, 0, sizeof (cache));
+  cache.magic = BOOTCACHE_MAGIC;
+  cache.version = BOOTCACHE_VERSION;
+  memcpy (cache.boot_id, boot_id, BOOTCACHE_ID_SIZE);
+  cache.boot_time = now - secs;
+  cache.wall_ref = now;
+  cache.mono_ref = mono.tv_sec;
+  cache_loaded = TRUE;
+  store_cache ();
+
+  return secs;
+#else
+  return source ();
+#endif
+}
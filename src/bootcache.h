@@ -0,0 +1,9 @@
+#pragma once
+
+#include <time.h>
+
+#define BOOTCACHE_BOOT_ID  "/proc/sys/kernel/random/boot_id"
+
+int bootcache_init (const char *, const char *);
+int bootcache_enabled (void);
+time_t bootcache_uptime (time_t (*)(void));
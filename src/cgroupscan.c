@@ -0,0 +1,549 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Age of the leaf cgroups of a cgroup v2 hierarchy
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The leaf cgroups (the containers, on a Kubernetes node) are checked
+ * against the thresholds like the uptime: a container restart recreates
+ * its cgroup, so its age is the time since the last restart.  The age of
+ * a cgroup is the start time of the oldest process listed in its
+ * cgroup.procs.  An empty leaf has no process, so the modification time
+ * of its cgroup.controllers file is used instead.  That time is only a
+ * lower bound of the age: the kernel does not store it, and sets it to
+ * the current time whenever the kernfs inode is evicted from memory and
+ * created again.
+ *
+ * The tree is walked by a pool of threads: each thread pops the directories
+ * to read from the bottom of its own deque and pushes there the ones it
+ * finds, and an idle thread steals from the top of the deque of the
+ * others.  The threads that find nothing to steal sleep until a directory
+ * is pushed.  The scan is over when no directory is queued nor being read.
+ */
+
+#include "config.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include "cgroupscan.h"
+#include "nputils.h"
+#include "procscan.h"
+#include "uptime.h"
+
+#define CGROUP_CREATED  "cgroup.controllers"
+#define CGROUP_PROCS    "cgroup.procs"
+
+struct cg_leaf
+{
+  char *path;			/* relative to the root */
+  time_t created;
+};
+
+struct cg_deque
+{
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+  pthread_mutex_t lock;
+#endif
+  char **items;
+  size_t top, bottom, size;	/* the items are in [top, bottom) */
+};
+
+struct cg_worker
+{
+  struct cg_scan *scan;
+  unsigned int id;
+  struct cg_deque deque;
+  struct cg_leaf *leaves;
+  size_t nleaves, size;
+  int error;
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+  pthread_t tid;
+  int threaded;
+#endif
+};
+
+struct cg_scan
+{
+  int rootfd;
+  int procfd;			/* /proc, for the start time of the processes */
+  time_t boot_time;
+  long hertz;
+  unsigned int nworkers;
+  struct cg_worker *workers;
+  long pending;			/* directories queued or being read */
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+  pthread_mutex_t idle_lock;
+  pthread_cond_t idle_cond;	/* a directory was pushed, or the end */
+  unsigned long pushes;		/* directories pushed so far */
+  unsigned int idle;		/* threads sleeping on idle_cond */
+#endif
+};
+
+static void
+cg_lock (struct cg_deque *dq)
+{
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+  pthread_mutex_lock (&dq->lock);
+#else
+  (void) dq;
+#endif
+}
+
+static void
+cg_unlock (struct cg_deque *dq)
+{
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+  pthread_mutex_unlock (&dq->lock);
+#else
+  (void) dq;
+#endif
+}
+
+/* Wake up the idle threads, if any */
+static void
+cg_wake (struct cg_scan *scan)
+{
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+  if (__atomic_load_n (&scan->idle, __ATOMIC_SEQ_CST) > 0)
+    {
+      pthread_mutex_lock (&scan->idle_lock);
+      pthread_cond_broadcast (&scan->idle_cond);
+      pthread_mutex_unlock (&scan->idle_lock);
+    }
+#else
+  (void) scan;
+#endif
+}
+
+/* A directory has been read, or could not be queued */
+static void
+cg_done (struct cg_scan *scan)
+{
+  if (__atomic_sub_fetch (&scan->pending, 1, __ATOMIC_SEQ_CST) == 0)
+    cg_wake (scan);
+}
+
+static int
+cg_push (struct cg_scan *scan, struct cg_deque *dq, char *path)
+{
+  char **items;
+  int ret = 0;
+
+  __atomic_add_fetch (&scan->pending, 1, __ATOMIC_RELAXED);
+  cg_lock (dq);
+  if (dq->bottom == dq->size && dq->top > 0)
+    {
+      memmove (dq->items, dq->items + dq->top,
+	       (dq->bottom - dq->top) * sizeof (char *));
+      dq->bottom -= dq->top;
+      dq->top = 0;
+    }
+  if (dq->bottom == dq->size)
+    {
+      dq->size = dq->size ? dq->size * 2 : 256;
+      if (NULL == (items = realloc (dq->items, dq->size * sizeof (char *))))
+	ret = -1;
+      else
+	dq->items = items;
+    }
+  if (ret == 0)
+    dq->items[dq->bottom++] = path;
+  cg_unlock (dq);
+
+  if (ret < 0)
+    {
+      free (path);
+      cg_done (scan);
+    }
+  else
+    {
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+      __atomic_add_fetch (&scan->pushes, 1, __ATOMIC_SEQ_CST);
+#endif
+      cg_wake (scan);
+    }
+  return ret;
+}
+
+/* Take a directory from the bottom (owner) or from the top (thief) */
+static char *
+cg_pop (struct cg_deque *dq, int steal)
+{
+  char *path = NULL;
+
+  cg_lock (dq);
+  if (dq->top < dq->bottom)
+    path = steal ? dq->items[dq->top++] : dq->items[--dq->bottom];
+  cg_unlock (dq);
+
+  return path;
+}
+
+static int
+cg_add_leaf (struct cg_worker *w, char *path, time_t created)
+{
+  struct cg_leaf *leaves;
+
+  if (w->nleaves == w->size)
+    {
+      w->size = w->size ? w->size * 2 : 256;
+      if (NULL == (leaves = realloc (w->leaves, w->size * sizeof (*leaves))))
+	return -1;
+      w->leaves = leaves;
+    }
+  w->leaves[w->nleaves].path = path;
+  w->leaves[w->nleaves].created = created;
+  w->nleaves++;
+
+  return 0;
+}
+
+static char *
+cg_join (const char *dir, const char *name)
+{
+  size_t dlen = strlen (dir), nlen = strlen (name);
+  char *path;
+
+  if (NULL == (path = malloc (dlen + nlen + 2)))
+    return NULL;
+  memcpy (path, dir, dlen);
+  path[dlen] = '/';
+  memcpy (path + dlen + 1, name, nlen + 1);
+
+  return path;
+}
+
+/*
+ * Boot time plus the start time of the oldest process listed in the
+ * cgroup.procs file of the cgroup 'fd'.  Returns -1 if there is none
+ */
+static time_t
+cg_oldest_process (struct cg_scan *scan, int fd)
+{
+  char buf[8192], stat[PROCSCAN_STATBUF];
+  unsigned long long start, oldest = 0;
+  unsigned int pid = 0;
+  ssize_t len, i;
+  int procs, found = FALSE, digits = FALSE;
+
+  if (scan->procfd < 0
+      || (procs = openat (fd, CGROUP_PROCS, O_RDONLY | O_CLOEXEC)) < 0)
+    return -1;
+
+  /* one pid per line */
+  while ((len = read (procs, buf, sizeof (buf))) > 0)
+    for (i = 0; i < len; i++)
+      if (buf[i] >= '0' && buf[i] <= '9')
+	{
+	  pid = pid * 10 + (buf[i] - '0');
+	  digits = TRUE;
+	}
+      else if (digits)
+	{
+	  if (procscan_read (scan->procfd, pid, "*", stat, &start) == 0
+	      && (!found || start < oldest))
+	    {
+	      oldest = start;
+	      found = TRUE;
+	    }
+	  pid = 0;
+	  digits = FALSE;
+	}
+  close (procs);
+
+  return found ? scan->boot_time + (time_t) (oldest / scan->hertz) : -1;
+}
+
+/* Read the directory 'path', queueing its children or recording a leaf */
+static void
+cg_visit (struct cg_worker *w, char *path)
+{
+  struct cg_scan *scan = w->scan;
+  struct dirent *d;
+  struct stat st;
+  DIR *dir;
+  char *child;
+  time_t created = -1;
+  int fd, children = 0;
+
+  if ((fd = openat (scan->rootfd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC))
+      < 0 || NULL == (dir = fdopendir (fd)))
+    {
+      if (fd >= 0)
+	close (fd);
+      free (path);		/* removed while scanning */
+      return;
+    }
+
+  while (NULL != (d = readdir (dir)))
+    {
+      if (d->d_name[0] == '.'
+	  || (d->d_type != DT_DIR && d->d_type != DT_UNKNOWN))
+	continue;
+      if (d->d_type == DT_UNKNOWN
+	  && (fstatat (fd, d->d_name, &st, AT_SYMLINK_NOFOLLOW) < 0
+	      || !S_ISDIR (st.st_mode)))
+	continue;
+      if (NULL == (child = cg_join (path, d->d_name))
+	  || cg_push (scan, &w->deque, child) < 0)
+	w->error = TRUE;
+      children++;
+    }
+
+  if (children == 0 && path[1] != '\0'
+      && (created = cg_oldest_process (scan, fd)) < 0
+      && fstatat (fd, CGROUP_CREATED, &st, 0) == 0)
+    created = st.st_mtime;
+
+  if (created >= 0)
+    {
+      if (cg_add_leaf (w, path, created) < 0)
+	{
+	  w->error = TRUE;
+	  free (path);
+	}
+    }
+  else
+    free (path);
+  closedir (dir);
+}
+
+static void *
+cg_work (void *arg)
+{
+  struct cg_worker *w = arg;
+  struct cg_scan *scan = w->scan;
+  unsigned int i;
+  char *path;
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+  unsigned long pushes;
+#endif
+
+  for (;;)
+    {
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+      /* read before looking, so that no push is missed */
+      pushes = __atomic_load_n (&scan->pushes, __ATOMIC_SEQ_CST);
+#endif
+      path = cg_pop (&w->deque, FALSE);
+      for (i = 1; NULL == path && i < scan->nworkers; i++)
+	path = cg_pop (&scan->workers[(w->id + i) % scan->nworkers].deque,
+		       TRUE);
+
+      if (path)
+	{
+	  cg_visit (w, path);
+	  cg_done (scan);
+	  continue;
+	}
+      if (__atomic_load_n (&scan->pending, __ATOMIC_SEQ_CST) == 0)
+	break;
+
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+      /* the other threads are reading directories: wait for their
+         children, or for the end of the scan */
+      pthread_mutex_lock (&scan->idle_lock);
+      __atomic_add_fetch (&scan->idle, 1, __ATOMIC_SEQ_CST);
+      while (__atomic_load_n (&scan->pushes, __ATOMIC_SEQ_CST) == pushes
+	     && __atomic_load_n (&scan->pending, __ATOMIC_SEQ_CST) != 0)
+	pthread_cond_wait (&scan->idle_cond, &scan->idle_lock);
+      __atomic_sub_fetch (&scan->idle, 1, __ATOMIC_SEQ_CST);
+      pthread_mutex_unlock (&scan->idle_lock);
+#endif
+    }
+
+  return NULL;
+}
+
+static int
+cg_leaf_compare (const void *a, const void *b)
+{
+  return strcmp (((const struct cg_leaf *) a)->path,
+		 ((const struct cg_leaf *) b)->path);
+}
+
+/*
+ * Scan the cgroup tree 'root' with 'threads' threads, the system having
+ * booted at 'boot_time'.  Returns the leaves sorted by path in 'leaves',
+ * or -1 on error
+ */
+static int
+cg_scan (const char *root, unsigned int threads, time_t boot_time,
+	 struct cg_leaf **leaves, size_t *nleaves)
+{
+  struct cg_scan scan;
+  struct cg_worker *w;
+  char *path;
+  size_t n;
+  unsigned int i;
+  int error = FALSE;
+
+#if !(HAVE_PTHREAD_H && HAVE_PTHREAD)
+  threads = 1;
+#endif
+  if (threads < 1)
+    threads = 1;
+
+  memset (&scan, 0, sizeof (scan));
+  if ((scan.rootfd = open (root, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
+    return -1;
+  scan.procfd = open (PROC_ROOT, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  scan.boot_time = boot_time;
+  if ((scan.hertz = sysconf (_SC_CLK_TCK)) <= 0)
+    scan.hertz = 100;
+  scan.nworkers = threads;
+  if (NULL == (scan.workers = calloc (threads, sizeof (struct cg_worker)))
+      || NULL == (path = strdup (".")))
+    {
+      free (scan.workers);
+      if (scan.procfd >= 0)
+	close (scan.procfd);
+      close (scan.rootfd);
+      return -1;
+    }
+
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+  pthread_mutex_init (&scan.idle_lock, NULL);
+  pthread_cond_init (&scan.idle_cond, NULL);
+#endif
+  for (i = 0; i < threads; i++)
+    {
+      scan.workers[i].scan = &scan;
+      scan.workers[i].id = i;
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+      pthread_mutex_init (&scan.workers[i].deque.lock, NULL);
+#endif
+    }
+  cg_push (&scan, &scan.workers[0].deque, path);
+
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+  for (i = 1; i < threads; i++)
+    scan.workers[i].threaded =
+      (pthread_create (&scan.workers[i].tid, NULL, cg_work,
+		       &scan.workers[i]) == 0);
+#endif
+  cg_work (&scan.workers[0]);
+
+  /* gather the leaves found by every thread */
+  for (n = 0, i = 0; i < threads; i++)
+    {
+      w = &scan.workers[i];
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+      if (w->threaded)
+	pthread_join (w->tid, NULL);
+      pthread_mutex_destroy (&w->deque.lock);
+#endif
+      error |= w->error;
+      n += w->nleaves;
+      free (w->deque.items);
+    }
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+  pthread_cond_destroy (&scan.idle_cond);
+  pthread_mutex_destroy (&scan.idle_lock);
+#endif
+
+  *nleaves = 0;
+  if (NULL == (*leaves = malloc ((n ? n : 1) * sizeof (struct cg_leaf))))
+    error = TRUE;
+  for (i = 0; i < threads; i++)
+    {
+      w = &scan.workers[i];
+      if (*leaves)
+	{
+	  memcpy (*leaves + *nleaves, w->leaves,
+		  w->nleaves * sizeof (struct cg_leaf));
+	  *nleaves += w->nleaves;
+	}
+      free (w->leaves);
+    }
+  free (scan.workers);
+  if (scan.procfd >= 0)
+    close (scan.procfd);
+  close (scan.rootfd);
+
+  if (*leaves)
+    qsort (*leaves, *nleaves, sizeof (struct cg_leaf), cg_leaf_compare);
+
+  return error ? -1 : 0;
+}
+
+/*
+ * Check the age in minutes of each leaf cgroup under 'root' against
+ * 'my_threshold': the worst state is returned, with the age of every
+ * leaf in the perfdata
+ */
+int
+cgroup_check (const char *root, unsigned int threads,
+	      const thresholds * my_threshold)
+{
+  struct cg_leaf *leaves;
+  struct age_target *targets;
+  size_t nleaves, i;
+  time_t now, uptime_secs;
+  int status;
+
+  if (UPTIME_RET_FAIL == (uptime_secs = uptime ()))
+    {
+      printf ("UPTIME UNKNOWN: can't get system uptime counter\n");
+      return STATE_UNKNOWN;
+    }
+  if (cg_scan (root, threads, time (NULL) - uptime_secs, &leaves,
+	       &nleaves) < 0)
+    {
+      printf ("UPTIME UNKNOWN: cannot scan the cgroups in %s\n", root);
+      return STATE_UNKNOWN;
+    }
+  if (nleaves == 0
+      || (targets = calloc (nleaves, sizeof (*targets))) == NULL)
+    {
+      for (i = 0; i < nleaves; i++)
+	free (leaves[i].path);
+      free (leaves);
+      printf ("UPTIME UNKNOWN: no cgroup found in %s\n", root);
+      return STATE_UNKNOWN;
+    }
+
+  /* the cgroups are named without the leading "./" */
+  now = time (NULL);
+  for (i = 0; i < nleaves; i++)
+    {
+      targets[i].name = leaves[i].path + 2;
+      targets[i].age =
+	(now > leaves[i].created) ? now - leaves[i].created : 0;
+    }
+  status = print_age_targets ("cgroups", targets, nleaves, my_threshold);
+
+  for (i = 0; i < nleaves; i++)
+    free (leaves[i].path);
+  free (leaves);
+  free (targets);
+
+  return status;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "nputils.h"
+
+int cgroup_check (const char *, unsigned int, const thresholds *);
@@ -22,28 +22,16 @@
 
 #include <assert.h>
 #include <fcntl.h>
+#include <limits.h>
 #if HAVE_GETOPT_H
 #include <getopt.h>
 #else
 #include <compat_getopt.h>
 #endif
 
-#if HAVE_KSTAT_H
-#include <kstat.h>
-#endif
-
-#if HAVE_LIBPERFSTAT
-#include <sys/protosw.h>
-#include <libperfstat.h>
-#endif
-
 #include <stdio.h>
 #include <stdlib.h>
 
-#if HAVE_SYS_SYSINFO_H
-#include <sys/sysinfo.h>
-#endif
-
 #if TIME_WITH_SYS_TIME
 #include <sys/time.h>
 #include <time.h>
@@ -57,19 +45,30 @@
 
 #include <unistd.h>
 
-#ifdef HAVE_SYS_PARAM_H
-#include <sys/param.h>
-#endif
-
-#if HAVE_SYS_SYSCTL_H
-#include <sys/sysctl.h>
-#endif
-
 #ifdef HAVE_SYS_TYPES_H
 #include <sys/types.h>
 #endif
 
+#include "availability.h"
+#include "batch.h"
+#include "bootcache.h"
+#include "cgroupscan.h"
+#include "cpustat.h"
+#include "daemon.h"
+#include "fleet.h"
+#include "history.h"
+#include "httpd.h"
 #include "nputils.h"
+#include "nrpe.h"
+#include "procscan.h"
+#include "procwatch.h"
+#include "shmstate.h"
+#include "sources.h"
+#include "sysmetrics.h"
+#include "textfile.h"
+#include "timens.h"
+#include "uptime.h"
+#include "wtmp.h"
 
 static const char *program_name = "check_update";
 static const char *program_version = PACKAGE_VERSION;
@@ -77,11 +76,49 @@ static const char *program_copyright =
   "Copyright (C) 2010,2012-2013 Davide Madrisan <" PACKAGE_BUGREPORT ">";
 
 #define BUFSIZE 127
-static char buf[BUFSIZE + 1];
-static char result_line[BUFSIZE + 1], perfdata_line[BUFSIZE + 1];
 
-time_t uptime (void);
-char *sprint_uptime (time_t);
+enum
+{
+  DAEMON_OPTION = CHAR_MAX + 1,
+  SOCKET_OPTION,
+  NRPE_OPTION,
+  LISTEN_OPTION,
+  TEXTFILE_OPTION,
+  INTERVAL_OPTION,
+  FSYNC_OPTION,
+  PUBLISH_SHM_OPTION,
+  FROM_SHM_OPTION,
+  SOURCE_OPTION,
+  BENCHMARK_SOURCES_OPTION,
+  BOOT_CACHE_OPTION,
+  BOOT_ID_OPTION,
+  HISTORY_OPTION,
+  REBOOTS_WARNING_OPTION,
+  REBOOTS_CRITICAL_OPTION,
+  REBOOTS_WINDOW_OPTION,
+  REBOOTS_SINCE_OPTION,
+  WTMP_OPTION,
+  AVAILABILITY_OPTION,
+  AVAILABILITY_WARNING_OPTION,
+  AVAILABILITY_CRITICAL_OPTION,
+  PROCESS_AGE_OPTION,
+  PROC_ROOT_OPTION,
+  THREADS_OPTION,
+  COUNT_WARNING_OPTION,
+  COUNT_CRITICAL_OPTION,
+  MIN_AGE_WARNING_OPTION,
+  MIN_AGE_CRITICAL_OPTION,
+  CGROUP_ROOT_OPTION,
+  TIMENS_OPTION,
+  BATCH_OPTION,
+  FLEET_OPTION,
+  FLEET_QUANTILE_OPTION,
+  METRICS_OPTION,
+  METRIC_WARNING_OPTION,
+  METRIC_CRITICAL_OPTION,
+  CPU_IDLE_OPTION,
+  PROC_STAT_OPTION
+};
 
 static void __attribute__ ((__noreturn__)) print_version (void)
 {
@@ -95,9 +132,103 @@ There is NO WARRANTY, to the extent permitted by law.\n", stdout);
   exit (STATE_OK);
 }
 
+/*
+ * Parse a duration: a number of seconds, optionally followed by one of the
+ * units 's', 'm', 'h', 'd' and 'w'.  Returns -1 if it is not valid
+ */
+static time_t
+parse_duration (const char *str)
+{
+  char *endptr;
+  unsigned long value, unit;
+
+  value = strtoul (str, &endptr, 10);
+  if (endptr == str)
+    return -1;
+
+  switch (*endptr)
+    {
+    case '\0':
+    case 's':
+      unit = 1;
+      break;
+    case 'm':
+      unit = 60;
+      break;
+    case 'h':
+      unit = 60 * 60;
+      break;
+    case 'd':
+      unit = 60 * 60 * 24;
+      break;
+    case 'w':
+      unit = 60 * 60 * 24 * 7;
+      break;
+    default:
+      return -1;
+    }
+  if (*endptr != '\0' && endptr[1] != '\0')
+    return -1;
+  if (value == 0 || value > INT_MAX / unit)
+    return -1;
+
+  return (time_t) (value * unit);
+}
+
 static struct option const longopts[] = {
   {(char *) "critical", required_argument, NULL, 'c'},
   {(char *) "warning", required_argument, NULL, 'w'},
+  {(char *) "daemon", no_argument, NULL, DAEMON_OPTION},
+  {(char *) "socket", required_argument, NULL, SOCKET_OPTION},
+  {(char *) "nrpe", required_argument, NULL, NRPE_OPTION},
+  {(char *) "listen", required_argument, NULL, LISTEN_OPTION},
+  {(char *) "textfile", required_argument, NULL, TEXTFILE_OPTION},
+  {(char *) "interval", required_argument, NULL, INTERVAL_OPTION},
+  {(char *) "fsync", no_argument, NULL, FSYNC_OPTION},
+  {(char *) "publish-shm", required_argument, NULL, PUBLISH_SHM_OPTION},
+  {(char *) "from-shm", required_argument, NULL, FROM_SHM_OPTION},
+  {(char *) "source", required_argument, NULL, SOURCE_OPTION},
+  {(char *) "benchmark-sources", no_argument, NULL,
+   BENCHMARK_SOURCES_OPTION},
+  {(char *) "boot-cache", required_argument, NULL, BOOT_CACHE_OPTION},
+  {(char *) "boot-id", required_argument, NULL, BOOT_ID_OPTION},
+  {(char *) "history", required_argument, NULL, HISTORY_OPTION},
+  {(char *) "reboots-warning", required_argument, NULL,
+   REBOOTS_WARNING_OPTION},
+  {(char *) "reboots-critical", required_argument, NULL,
+   REBOOTS_CRITICAL_OPTION},
+  {(char *) "reboots-window", required_argument, NULL,
+   REBOOTS_WINDOW_OPTION},
+  {(char *) "reboots-since", required_argument, NULL, REBOOTS_SINCE_OPTION},
+  {(char *) "wtmp", required_argument, NULL, WTMP_OPTION},
+  {(char *) "availability", required_argument, NULL, AVAILABILITY_OPTION},
+  {(char *) "availability-warning", required_argument, NULL,
+   AVAILABILITY_WARNING_OPTION},
+  {(char *) "availability-critical", required_argument, NULL,
+   AVAILABILITY_CRITICAL_OPTION},
+  {(char *) "process-age", required_argument, NULL, PROCESS_AGE_OPTION},
+  {(char *) "proc-root", required_argument, NULL, PROC_ROOT_OPTION},
+  {(char *) "threads", required_argument, NULL, THREADS_OPTION},
+  {(char *) "count-warning", required_argument, NULL, COUNT_WARNING_OPTION},
+  {(char *) "count-critical", required_argument, NULL,
+   COUNT_CRITICAL_OPTION},
+  {(char *) "min-age-warning", required_argument, NULL,
+   MIN_AGE_WARNING_OPTION},
+  {(char *) "min-age-critical", required_argument, NULL,
+   MIN_AGE_CRITICAL_OPTION},
+  {(char *) "cgroup-root", required_argument, NULL, CGROUP_ROOT_OPTION},
+  {(char *) "timens", required_argument, NULL, TIMENS_OPTION},
+  {(char *) "batch", required_argument, NULL, BATCH_OPTION},
+  {(char *) "fleet", required_argument, NULL, FLEET_OPTION},
+  {(char *) "fleet-quantile", required_argument, NULL,
+   FLEET_QUANTILE_OPTION},
+  {(char *) "metrics", no_argument, NULL, METRICS_OPTION},
+  {(char *) "metric-warning", required_argument, NULL,
+   METRIC_WARNING_OPTION},
+  {(char *) "metric-critical", required_argument, NULL,
+   METRIC_CRITICAL_OPTION},
+  {(char *) "cpu-idle", no_argument, NULL, CPU_IDLE_OPTION},
+  {(char *) "proc-stat", required_argument, NULL, PROC_STAT_OPTION},
   {(char *) "help", no_argument, NULL, 'h'},
   {(char *) "version", no_argument, NULL, 'V'},
   {NULL, 0, NULL, 0}
@@ -105,6 +236,8 @@ static struct option const longopts[] = {
 
 static void __attribute__ ((__noreturn__)) usage (FILE * out)
 {
+  const struct uptime_source *src;
+
   fprintf (out,
 	   "%s, version %s - check how long the system has been running.\n",
 	   program_name, program_version);
@@ -114,6 +247,85 @@ static void __attribute__ ((__noreturn__)) usage (FILE * out)
 Options:\n\
   -w, --warning [@]start:end]   warning threshold\n\
   -c, --critical [@]start:end]   critical threshold\n\
+  --daemon              keep running and answer the checks on a socket\n\
+  --socket PATH         the Unix socket used by the daemon; without\n\
+                        --daemon, ask the daemon listening on PATH\n\
+  --nrpe [ADDR:]PORT    run a NRPE (v2/v3) compatible server\n\
+  --listen [ADDR:]PORT  export the metrics over HTTP at /metrics\n\
+  --textfile DIR        write the metrics in DIR/uptime.prom for the\n\
+                        Prometheus textfile collector\n\
+  --interval SECS       with --textfile, update the file every SECS seconds\n\
+  --fsync               with --textfile, sync the file to disk\n\
+  --publish-shm NAME    publish the uptime and the check state in the\n\
+                        POSIX shared memory NAME every --interval seconds\n\
+  --from-shm NAME       check the uptime published in the shared memory NAME\n\
+  --source NAME         read the uptime from the source NAME\n\
+  --benchmark-sources   measure the cost of each uptime source and exit\n\
+  --boot-cache FILE     cache the boot time in FILE (e.g. /run/check_uptime)\n\
+  --boot-id PATH        with --boot-cache, read the boot identifier from\n\
+                        PATH (default: " BOOTCACHE_BOOT_ID ")\n\
+  --history FILE        record the uptime in the ring buffer FILE and\n\
+                        count the reboots\n\
+  --reboots-warning [@]start:end]   with --history or --reboots-since,\n\
+                        warning threshold for the reboots in the window\n\
+  --reboots-critical [@]start:end]   with --history or --reboots-since,\n\
+                        critical threshold for the reboots in the window\n\
+  --reboots-window HOURS   with --history, count the reboots of the last\n\
+                        HOURS hours (default: 24)\n\
+  --reboots-since DURATION   count the reboots recorded in wtmp in the\n\
+                        last DURATION (e.g. 3600, 90m, 12h, 7d, 2w)\n\
+  --wtmp PATH           with --reboots-since or --availability, the wtmp\n\
+                        file to read\n\
+                        (default: " WTMP_PATH ")\n\
+  --availability INDEX  report the percent of time up in the last 30, 90\n\
+                        and 365 days, kept in the index file INDEX\n\
+  --availability-warning [@]start:end]   with --availability, warning\n\
+                        threshold for the availability percents\n\
+  --availability-critical [@]start:end]   with --availability, critical\n\
+                        threshold for the availability percents\n\
+  --process-age PATTERN   check the age in minutes of the oldest process\n\
+                        whose name matches the shell PATTERN; with\n\
+                        --daemon, track them with the proc connector\n\
+  --proc-root PATH      with --process-age or --timens, the proc\n\
+                        filesystem to scan\n\
+                        (default: " PROC_ROOT ")\n\
+  --cgroup-root PATH    check the age in minutes of each leaf cgroup of\n\
+                        the cgroup v2 tree PATH\n\
+  --timens LIST         check the uptime seen in the time namespace of\n\
+                        each pid or namespace path of the comma separated\n\
+                        LIST (e.g. 1234,/run/timens/web)\n\
+  --batch FILE          check the uptime files (or the directories holding\n\
+                        them) listed one per line in FILE ('-' for stdin),\n\
+                        read together with io_uring\n\
+  --fleet PATH          aggregate per group the \"HOST UPTIME [GROUP]\"\n\
+                        snapshots in the file or directory PATH\n\
+  --fleet-quantile Q    with --fleet, check the Q percentile of the uptimes\n\
+                        (default: 5); the reboots thresholds apply to the\n\
+                        percent of hosts rebooted in --reboots-since\n\
+                        (default: 1h)\n\
+  --metrics             check and report all the sysinfo() metrics: uptime,\n\
+                        load1, load5, load15, tasks, ram_total, ram_free,\n\
+                        ram_shared, ram_buffer, ram_free_pct, swap_total,\n\
+                        swap_free, swap_used_pct, high_total, high_free\n\
+  --metric-warning NAME=[@]start:end]   with --metrics, warning threshold\n\
+                        for the metric NAME (repeatable)\n\
+  --metric-critical NAME=[@]start:end]   with --metrics, critical\n\
+                        threshold for the metric NAME (repeatable)\n\
+  --cpu-idle            check the percent of time each CPU has been idle\n\
+                        since boot (the minimum and the maximum)\n\
+  --proc-stat PATH      with --cpu-idle, the file to read\n\
+                        (default: " PROC_STAT ")\n\
+  --threads N           with --process-age, --cgroup-root, --timens,\n\
+                        --batch or --fleet, scan with N threads\n\
+  --count-warning [@]start:end]   with --process-age, warning threshold\n\
+                        for the number of matching processes\n\
+  --count-critical [@]start:end]   with --process-age, critical threshold\n\
+                        for the number of matching processes\n\
+  --min-age-warning [@]start:end]   with --process-age, warning threshold\n\
+                        for the age in minutes of the youngest process\n\
+  --min-age-critical [@]start:end]   with --process-age, critical\n\
+                        threshold for the age in minutes of the youngest\n\
+                        process\n\
   -h, --help            display this help and exit\n\
   -v, --version         output version information and exit\n\n", out);
 
@@ -127,134 +339,75 @@ Where:\n\
   6. if range starts with \"@\", then alert if inside this range (inclusive of endpoints)\n\n", out);
   fprintf (out, "Examples:\n  %s\n  %s --warning 30: --critical 15:\n",
 	   program_name, program_name);
+  fprintf (out, "  %s --daemon --socket /run/check_uptime.sock"
+	   " --warning 30: &\n"
+	   "  %s --socket /run/check_uptime.sock --critical 15:\n"
+	   "  %s --nrpe 127.0.0.1:5666 --warning 30: &\n"
+	   "  %s --listen :9101 --warning 30: &\n"
+	   "  %s --textfile /var/lib/node_exporter --interval 15 &\n"
+	   "  %s --publish-shm /check_uptime --warning 30: &\n"
+	   "  %s --from-shm /check_uptime --critical 15:\n"
+	   "  %s --history /var/lib/check_uptime.hist --reboots-warning 2"
+	   " --reboots-critical 5\n"
+	   "  %s --reboots-since 7d --reboots-warning 1 --reboots-critical 3\n"
+	   "  %s --availability /var/lib/check_uptime.avail"
+	   " --availability-critical 99.9:\n"
+	   "  %s --process-age 'worker*' --warning 1440 --count-critical 1:\n"
+	   "  %s --cgroup-root /sys/fs/cgroup/kubepods.slice --threads 4"
+	   " --warning 30: --critical 10:\n"
+	   "  %s --timens 1234,5678,/proc/9012/ns/time --critical 5:\n"
+	   "  ls -d /srv/roots/*/proc | %s --batch - --critical 15:\n"
+	   "  %s --fleet /var/spool/uptime --critical 1440: --reboots-since 1h"
+	   " --reboots-warning 2\n"
+	   "  %s --metrics --metric-warning load1=8 --metric-critical"
+	   " swap_used_pct=90\n"
+	   "  %s --cpu-idle --warning 5:95 --critical 1:\n",
+	   program_name, program_name, program_name, program_name,
+	   program_name, program_name, program_name, program_name,
+	   program_name, program_name, program_name, program_name,
+	   program_name, program_name, program_name, program_name,
+	   program_name);
+  fputs ("\nUptime sources (the first available one is the default):\n",
+	 out);
+  for (src = uptime_sources; src->name; src++)
+    fprintf (out, "  %-10s  %s\n", src->name, src->description);
 
   exit (out == stderr ? STATE_UNKNOWN : STATE_OK);
 }
 
-/* assume uptime never be zero seconds in practice */
-#define UPTIME_RET_FAIL  0
-
-time_t
-uptime ()
-{
-#if defined(HAVE_STRUCT_SYSINFO_WITH_UPTIME)	/* Linux */
-
-  struct sysinfo info;
-
-  if (0 != sysinfo (&info))
-    {
-      perror ("cannot get the system uptime");
-      return UPTIME_RET_FAIL;
-    }
-
-  return (time_t) info.uptime;
-
-#elif defined(HAVE_FUNCTION_SYSCTL_KERN_BOOTTIME)	/* FreeBSD */
-
-  int mib[] = { CTL_KERN, KERN_BOOTTIME };
-  struct timeval system_uptime;
-  size_t len = sizeof (system_uptime);
-
-  if (0 != sysctl (mib, 2, &system_uptime, &len, NULL, 0))
-    return UPTIME_RET_FAIL;
-
-  return (time (NULL) - system_uptime.tv_sec);
-
-#elif defined(HAVE_KSTAT_H)	/* Solaris */
-
-  kstat_ctl_t *kc;
-  kstat_t *ksp;
-  kstat_named_t *knp;
-
-  time_t now;
-
-  if (NULL == (kc = kstat_open ()))
-    return UPTIME_RET_FAIL;
-
-  if (NULL !=
-      (ksp = kstat_lookup (kc, (char *) "unix", 0, (char *) "system_misc")))
-    {
-      if (-1 != kstat_read (kc, ksp, 0))
-	{
-	  if (NULL != (knp = kstat_data_lookup (ksp, (char *) "boot_time")))
-	    {
-	      time (&now);
-	      kstat_close (kc);
-	      return (difftime (now, (time_t) knp->value.ul));
-	    }
-	}
-    }
-
-  kstat_close (kc);
-  return UPTIME_RET_FAIL;
-
-#elif defined(HAVE_LIBPERFSTAT)	/* AIX */
-
-  long hertz = 0;
-  perfstat_cpu_total_t ps_cpu_total;
-
-  // get the number of clock ticks per second
-  hertz = sysconf (_SC_CLK_TCK);
-
-  if (-1 ==
-      perfstat_cpu_total (NULL, &ps_cpu_total, sizeof (ps_cpu_total), 1))
-    return UPTIME_RET_FAIL;
-
-  // lbolt contains the number of ticks since last reboot
-  return ps_cpu_total.lbolt / hertz;
-
-#elif defined(HAVE_CLOCK_GETTIME_MONOTONIC) /* POSIX.1-2001 */
-
-  struct timespec t;
-
-  clock_gettime (CLOCK_MONOTONIC, &t);
-  if (t.tv_sec > 0)
-    return t.tv_sec;
-  else
-    return UPTIME_RET_FAIL;
-
-#else
-
-  return UPTIME_RET_FAIL;
-
-#endif
-}
-
-char *
-sprint_uptime (time_t uptime_secs)
-{
-  unsigned int upminutes, uphours, updays;
-  int pos = 0;
-
-  updays = (unsigned int) (uptime_secs / (60 * 60 * 24));
-  if (updays)
-    pos +=
-      snprintf (buf, BUFSIZE, "%u day%s ", updays, (updays != 1) ? "s" : "");
-  upminutes = (unsigned int) (uptime_secs / 60);
-  uphours = upminutes / 60;
-  uphours = uphours % 24;
-  upminutes = upminutes % 60;
-
-  if (uphours)
-    {
-      pos +=
-	snprintf (buf + pos, BUFSIZE - pos, "%u hour%s %u min", uphours,
-		  (uphours != 1) ? "s" : "", upminutes);
-    }
-  else
-    pos += snprintf (buf + pos, BUFSIZE - pos, "%u min", upminutes);
-
-  return buf;
-}
-
 int
 main (int argc, char **argv)
 {
-  int c, status;
-  char *critical = NULL, *warning = NULL;
+  int c, status, daemon_mode = FALSE;
+  char *critical = NULL, *warning = NULL, *socket_path = NULL;
+  char *nrpe_address = NULL, *listen_address = NULL, *textfile_dir = NULL;
+  char *publish_shm = NULL, *from_shm = NULL, *source = NULL, *endptr;
+  char *boot_cache = NULL, *boot_id = NULL, *history_file = NULL;
+  char *reboots_warning = NULL, *reboots_critical = NULL;
+  char *reboots_since = NULL;
+  const char *wtmp_path = WTMP_PATH;
+  char *availability_index = NULL, *availability_warning = NULL;
+  char *availability_critical = NULL;
+  char *process_age = NULL, *count_warning = NULL, *count_critical = NULL;
+  char *min_age_warning = NULL, *min_age_critical = NULL;
+  const char *proc_root = PROC_ROOT, *cgroup_root = NULL, *timens = NULL;
+  const char *batch_list = NULL, *fleet_path = NULL;
+  double fleet_quantile = 5;
+  const char *metric_warnings[SYSMETRICS_MAX_RANGES];
+  const char *metric_criticals[SYSMETRICS_MAX_RANGES];
+  size_t metric_nwarnings = 0, metric_ncriticals = 0;
+  int metrics = FALSE, cpu_idle = FALSE;
+  const char *proc_stat = PROC_STAT;
+  unsigned long threads = 1;
+  unsigned long reboots_window = 24;
+  time_t reboots_since_secs = 0;
+  unsigned long interval = 0;
+  int do_fsync = FALSE, benchmark = FALSE;
+  char result_line[BUFSIZE + 1];
   time_t uptime_secs;
-  unsigned int uptime_mins;
-  thresholds *my_threshold = NULL;
+  thresholds my_threshold, reboot_threshold, availability_threshold;
+  thresholds count_threshold, min_age_threshold;
+  const thresholds *min_age = NULL;
 
   while ((c = getopt_long (argc, argv, "c:w:hV", longopts, NULL)) != -1)
     {
@@ -269,6 +422,140 @@ main (int argc, char **argv)
 	case 'w':
 	  warning = optarg;
 	  break;
+	case DAEMON_OPTION:
+	  daemon_mode = TRUE;
+	  break;
+	case SOCKET_OPTION:
+	  socket_path = optarg;
+	  break;
+	case NRPE_OPTION:
+	  nrpe_address = optarg;
+	  break;
+	case LISTEN_OPTION:
+	  listen_address = optarg;
+	  break;
+	case TEXTFILE_OPTION:
+	  textfile_dir = optarg;
+	  break;
+	case INTERVAL_OPTION:
+	  interval = strtoul (optarg, &endptr, 10);
+	  if (*endptr != '\0' || endptr == optarg || interval > UINT_MAX)
+	    usage (stderr);
+	  break;
+	case FSYNC_OPTION:
+	  do_fsync = TRUE;
+	  break;
+	case PUBLISH_SHM_OPTION:
+	  publish_shm = optarg;
+	  break;
+	case FROM_SHM_OPTION:
+	  from_shm = optarg;
+	  break;
+	case SOURCE_OPTION:
+	  source = optarg;
+	  break;
+	case BENCHMARK_SOURCES_OPTION:
+	  benchmark = TRUE;
+	  break;
+	case BOOT_CACHE_OPTION:
+	  boot_cache = optarg;
+	  break;
+	case BOOT_ID_OPTION:
+	  boot_id = optarg;
+	  break;
+	case HISTORY_OPTION:
+	  history_file = optarg;
+	  break;
+	case REBOOTS_WARNING_OPTION:
+	  reboots_warning = optarg;
+	  break;
+	case REBOOTS_CRITICAL_OPTION:
+	  reboots_critical = optarg;
+	  break;
+	case REBOOTS_WINDOW_OPTION:
+	  reboots_window = strtoul (optarg, &endptr, 10);
+	  if (*endptr != '\0' || endptr == optarg || reboots_window == 0
+	      || reboots_window > UINT_MAX / 3600)
+	    usage (stderr);
+	  break;
+	case REBOOTS_SINCE_OPTION:
+	  reboots_since = optarg;
+	  if ((reboots_since_secs = parse_duration (optarg)) < 0)
+	    usage (stderr);
+	  break;
+	case WTMP_OPTION:
+	  wtmp_path = optarg;
+	  break;
+	case AVAILABILITY_OPTION:
+	  availability_index = optarg;
+	  break;
+	case AVAILABILITY_WARNING_OPTION:
+	  availability_warning = optarg;
+	  break;
+	case AVAILABILITY_CRITICAL_OPTION:
+	  availability_critical = optarg;
+	  break;
+	case PROCESS_AGE_OPTION:
+	  process_age = optarg;
+	  break;
+	case PROC_ROOT_OPTION:
+	  proc_root = optarg;
+	  break;
+	case THREADS_OPTION:
+	  threads = strtoul (optarg, &endptr, 10);
+	  if (*endptr != '\0' || endptr == optarg || threads == 0
+	      || threads > PROCSCAN_MAX_THREADS)
+	    usage (stderr);
+	  break;
+	case COUNT_WARNING_OPTION:
+	  count_warning = optarg;
+	  break;
+	case COUNT_CRITICAL_OPTION:
+	  count_critical = optarg;
+	  break;
+	case MIN_AGE_WARNING_OPTION:
+	  min_age_warning = optarg;
+	  break;
+	case MIN_AGE_CRITICAL_OPTION:
+	  min_age_critical = optarg;
+	  break;
+	case CGROUP_ROOT_OPTION:
+	  cgroup_root = optarg;
+	  break;
+	case TIMENS_OPTION:
+	  timens = optarg;
+	  break;
+	case BATCH_OPTION:
+	  batch_list = optarg;
+	  break;
+	case METRICS_OPTION:
+	  metrics = TRUE;
+	  break;
+	case METRIC_WARNING_OPTION:
+	  if (metric_nwarnings == SYSMETRICS_MAX_RANGES)
+	    usage (stderr);
+	  metric_warnings[metric_nwarnings++] = optarg;
+	  break;
+	case METRIC_CRITICAL_OPTION:
+	  if (metric_ncriticals == SYSMETRICS_MAX_RANGES)
+	    usage (stderr);
+	  metric_criticals[metric_ncriticals++] = optarg;
+	  break;
+	case CPU_IDLE_OPTION:
+	  cpu_idle = TRUE;
+	  break;
+	case PROC_STAT_OPTION:
+	  proc_stat = optarg;
+	  break;
+	case FLEET_OPTION:
+	  fleet_path = optarg;
+	  break;
+	case FLEET_QUANTILE_OPTION:
+	  fleet_quantile = strtod (optarg, &endptr);
+	  if (*endptr != '\0' || endptr == optarg || fleet_quantile < 0
+	      || fleet_quantile > 100)
+	    usage (stderr);
+	  break;
 	case 'h':
 	  usage (stdout);
 	  break;
@@ -281,38 +568,101 @@ main (int argc, char **argv)
   status = set_thresholds (&my_threshold, warning, critical);
   if (status == NP_RANGE_UNPARSEABLE)
     usage (stderr);
+  status = set_thresholds (&reboot_threshold, reboots_warning,
+			   reboots_critical);
+  if (status == NP_RANGE_UNPARSEABLE)
+    usage (stderr);
+  status = set_thresholds (&availability_threshold, availability_warning,
+			   availability_critical);
+  if (status == NP_RANGE_UNPARSEABLE)
+    usage (stderr);
+  status = set_thresholds (&count_threshold, count_warning, count_critical);
+  if (status == NP_RANGE_UNPARSEABLE)
+    usage (stderr);
+  status = set_thresholds (&min_age_threshold, min_age_warning,
+			   min_age_critical);
+  if (status == NP_RANGE_UNPARSEABLE)
+    usage (stderr);
+  if (min_age_warning || min_age_critical)
+    min_age = &min_age_threshold;
 
-  if (UPTIME_RET_FAIL != (uptime_secs = uptime ()))
+  if (benchmark)
+    return benchmark_sources ();
+
+  if (source && uptime_set_source (source) != 0)
     {
-      uptime_mins = (unsigned int) (uptime_secs / 60);
-      status = get_status (uptime_mins, my_threshold);
-      free (my_threshold);
+      printf ("UPTIME UNKNOWN: uptime source '%s' is not available\n",
+	      source);
+      return STATE_UNKNOWN;
+    }
 
-      switch (status)
-	{
-	case STATE_CRITICAL:
-	  c = snprintf (result_line, BUFSIZE, "UPTIME CRITICAL:");
-	  break;
-	case STATE_WARNING:
-	  c = snprintf (result_line, BUFSIZE, "UPTIME WARNING:");
-	  break;
-	case STATE_OK:
-	  c = snprintf (result_line, BUFSIZE, "UPTIME OK:");
-	  break;
-	}
+  if (boot_cache && bootcache_init (boot_cache, boot_id) != 0)
+    {
+      printf ("UPTIME UNKNOWN: the boot time cache is not supported\n");
+      return STATE_UNKNOWN;
+    }
 
-      snprintf (result_line + c, BUFSIZE - c, " %s",
-		sprint_uptime (uptime_secs));
-      snprintf (perfdata_line, BUFSIZE, "uptime=%u", uptime_mins);
+  if (publish_shm)
+    return shm_publisher (publish_shm, (unsigned int) interval,
+			  &my_threshold);
+  else if (from_shm)
+    return shm_check (from_shm, &my_threshold);
+  else if (textfile_dir)
+    return textfile_writer (textfile_dir, (unsigned int) interval,
+			    do_fsync, &my_threshold);
+  else if (listen_address)
+    return metrics_server (listen_address, &my_threshold);
+  else if (nrpe_address)
+    return nrpe_server (nrpe_address, warning, critical);
+  else if (daemon_mode && process_age)
+    return procwatch_daemon (socket_path, proc_root, process_age, warning,
+			     critical, &count_threshold, min_age);
+  else if (daemon_mode)
+    return uptime_daemon (socket_path, warning, critical);
+  else if (socket_path)
+    return uptime_client (socket_path, warning, critical);
+  else if (history_file)
+    return history_check (history_file, (unsigned int) reboots_window,
+			  &my_threshold, &reboot_threshold);
+  else if (cpu_idle)
+    return cpustat_check (proc_stat, &my_threshold);
+  else if (metrics)
+    return sysmetrics_check (metric_warnings, metric_nwarnings,
+			     metric_criticals, metric_ncriticals,
+			     &my_threshold);
+  else if (fleet_path)
+    return fleet_check (fleet_path, (unsigned int) threads, fleet_quantile,
+			reboots_since ? reboots_since : "1h",
+			reboots_since ? reboots_since_secs : 3600,
+			&my_threshold, &reboot_threshold);
+  else if (reboots_since)
+    return wtmp_check (wtmp_path, reboots_since, reboots_since_secs,
+		       &my_threshold, &reboot_threshold);
+  else if (availability_index)
+    return availability_check (availability_index, wtmp_path,
+			       &my_threshold, &availability_threshold);
+  else if (cgroup_root)
+    return cgroup_check (cgroup_root, (unsigned int) threads, &my_threshold);
+  else if (timens)
+    return timens_check (timens, proc_root, (unsigned int) threads,
+			 &my_threshold);
+  else if (batch_list)
+    return batch_check (batch_list, (unsigned int) threads, &my_threshold);
+  else if (process_age)
+    return process_age_check (proc_root, process_age, (unsigned int) threads,
+			      &my_threshold, &count_threshold, min_age);
 
-      printf ("%s|%s\n", result_line, perfdata_line);
-    }
+  if (UPTIME_RET_FAIL != (uptime_secs = uptime ()))
+    status = sprint_check_result (result_line, sizeof (result_line),
+				  uptime_secs, &my_threshold);
   else
     {
-      c = snprintf (result_line, BUFSIZE,
-		    "UPTIME UNKNOWN: can't get system uptime counter");
+      snprintf (result_line, sizeof (result_line),
+		"UPTIME UNKNOWN: can't get system uptime counter");
       status = STATE_UNKNOWN;
     }
 
+  printf ("%s\n", result_line);
+
   return status;
 }
@@ -0,0 +1,174 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Minimal startup build of check_uptime (configure --enable-minimal)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Same checks and output as check_uptime, but the arguments are parsed by
+ * hand and the output line is built in one stack buffer and written with
+ * a single write(), so that the (static) binary does not need stdio nor
+ * getopt and maps as few pages as possible.  Only the --warning and
+ * --critical options are supported.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nputils.h"
+#include "uptime.h"
+
+#define LINE_SIZE  128
+
+static const char usage_text[] = "\
+Usage: check_uptime_min [-w|--warning [@]start:end] \
+[-c|--critical [@]start:end]\n";
+
+struct line
+{
+  char buf[LINE_SIZE];
+  size_t len;
+};
+
+static void
+put_str (struct line *l, const char *s)
+{
+  while (*s && l->len < LINE_SIZE - 1)
+    l->buf[l->len++] = *s++;
+}
+
+static void
+put_uint (struct line *l, unsigned int n)
+{
+  char digits[16];
+  int i = 0;
+
+  do
+    digits[i++] = '0' + n % 10;
+  while ((n /= 10) > 0);
+
+  while (i > 0 && l->len < LINE_SIZE - 1)
+    l->buf[l->len++] = digits[--i];
+}
+
+/* Same output as sprint_uptime() */
+static void
+put_uptime (struct line *l, time_t uptime_secs)
+{
+  unsigned int upminutes, uphours, updays;
+
+  updays = (unsigned int) (uptime_secs / (60 * 60 * 24));
+  if (updays)
+    {
+      put_uint (l, updays);
+      put_str (l, (updays != 1) ? " days " : " day ");
+    }
+  upminutes = (unsigned int) (uptime_secs / 60);
+  uphours = (upminutes / 60) % 24;
+  upminutes = upminutes % 60;
+
+  if (uphours)
+    {
+      put_uint (l, uphours);
+      put_str (l, (uphours != 1) ? " hours " : " hour ");
+    }
+  put_uint (l, upminutes);
+  put_str (l, " min");
+}
+
+static int __attribute__ ((__noreturn__)) usage (int fd)
+{
+  if (write (fd, usage_text, sizeof (usage_text) - 1) < 0)
+    _exit (STATE_UNKNOWN);
+  _exit (fd == STDERR_FILENO ? STATE_UNKNOWN : STATE_OK);
+}
+
+/*
+ * Returns the value of the option 'argv[*i]' if it is the short option
+ * 'short_opt' or the long option 'long_opt', otherwise NULL
+ */
+static char *
+option_value (char **argv, int argc, int *i, const char *short_opt,
+	      const char *long_opt)
+{
+  char *arg = argv[*i];
+  size_t len = strlen (long_opt);
+
+  if (!strcmp (arg, short_opt) || !strcmp (arg, long_opt))
+    {
+      if (++*i == argc)
+	usage (STDERR_FILENO);
+      return argv[*i];
+    }
+  if (!strncmp (arg, short_opt, 2) && arg[2] != '\0' && arg[1] != '-')
+    return arg + 2;
+  if (!strncmp (arg, long_opt, len) && arg[len] == '=')
+    return arg + len + 1;
+
+  return NULL;
+}
+
+int
+main (int argc, char **argv)
+{
+  char *critical = NULL, *warning = NULL, *value;
+  struct line l;
+  thresholds my_threshold;
+  time_t uptime_secs;
+  int i, status;
+
+  for (i = 1; i < argc; i++)
+    {
+      if (NULL != (value = option_value (argv, argc, &i, "-w", "--warning")))
+	warning = value;
+      else if (NULL !=
+	       (value = option_value (argv, argc, &i, "-c", "--critical")))
+	critical = value;
+      else if (!strcmp (argv[i], "-h") || !strcmp (argv[i], "--help"))
+	usage (STDOUT_FILENO);
+      else
+	usage (STDERR_FILENO);
+    }
+
+  if (set_thresholds (&my_threshold, warning, critical) != 0)
+    usage (STDERR_FILENO);
+
+  l.len = 0;
+  if (UPTIME_RET_FAIL != (uptime_secs = uptime ()))
+    {
+      status = get_status ((unsigned int) (uptime_secs / 60), &my_threshold);
+      put_str (&l, (status == STATE_CRITICAL) ? "UPTIME CRITICAL: " :
+	       (status == STATE_WARNING) ? "UPTIME WARNING: " : "UPTIME OK: ");
+      put_uptime (&l, uptime_secs);
+      put_str (&l, "|uptime=");
+      put_uint (&l, (unsigned int) (uptime_secs / 60));
+    }
+  else
+    {
+      put_str (&l, "UPTIME UNKNOWN: can't get system uptime counter");
+      status = STATE_UNKNOWN;
+    }
+  l.buf[l.len++] = '\n';
+
+  if (write (STDOUT_FILENO, l.buf, l.len) < 0)
+    return STATE_UNKNOWN;
+
+  return status;
+}
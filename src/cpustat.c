@@ -0,0 +1,264 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Idle ratio of each CPU since boot, from /proc/stat
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The idle ratio of a CPU is its idle and iowait time, in clock ticks,
+ * over the uptime.  A pinned or stuck core shows up as the minimum across
+ * the CPUs, a dead one as the maximum.  For a file other than /proc/stat,
+ * captured on another machine, the uptime is the one accounted in the
+ * aggregated "cpu" line.
+ *
+ * /proc/stat is read with a single pread() into a buffer kept between the
+ * calls and grown when the file does not fit.  Only the "cpu" lines, at
+ * the top of the file, are parsed, by a hand written integer scanner
+ * converting the first eight fields of each line; the line ends are found
+ * with memchr(), vectorized by the C library, and the parsing stops at the
+ * first line of another kind, before the huge "intr" line of the large
+ * machines.
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cpustat.h"
+#include "nputils.h"
+#include "uptime.h"
+
+#define CPUSTAT_BUFSIZE  65536
+
+/* Scan the unsigned integer at 'p', after the blanks.  Returns its end */
+static const char *
+cpustat_number (const char *p, const char *end, unsigned long long *value)
+{
+  unsigned long long v = 0;
+
+  while (p < end && *p == ' ')
+    p++;
+  while (p < end && (unsigned char) (*p - '0') < 10)
+    v = v * 10 + (unsigned long long) (*p++ - '0');
+  *value = v;
+
+  return p;
+}
+
+/*
+ * Parse the cpu lines of 'buf', the whole file if 'eof'.  Returns the
+ * number of CPUs, -1 if the lines may go on past 'buf'
+ */
+static ssize_t
+cpustat_parse (const char *buf, size_t len, int eof,
+	       struct cpustat_cpu *cpus, size_t ncpus)
+{
+  const char *p = buf, *end = buf + len, *eol;
+  unsigned long long id, value, idle, total;
+  size_t n = 0;
+  int i;
+
+  while (p < end)
+    {
+      /* a tail cut within "cpu" may still be a cpu line */
+      if ((size_t) (end - p) < 3)
+	{
+	  if (!eof && memcmp (p, "cpu", (size_t) (end - p)) == 0)
+	    return -1;
+	  break;
+	}
+      if (memcmp (p, "cpu", 3) != 0)
+	break;
+      if ((eol = memchr (p, '\n', (size_t) (end - p))) == NULL)
+	{
+	  if (!eof)
+	    return -1;
+	  eol = end;
+	}
+      p += 3;
+      if (*p == ' ')
+	id = (unsigned long long) -1;
+      else
+	p = cpustat_number (p, eol, &id);
+
+      /* user nice system idle iowait irq softirq steal guest guest_nice,
+         the guest time being already in user and nice */
+      for (i = idle = total = 0; i < 8 && p < eol; i++)
+	{
+	  p = cpustat_number (p, eol, &value);
+	  total += value;
+	  if (i == 3 || i == 4)
+	    idle += value;
+	}
+      if (n < ncpus)
+	{
+	  cpus[n].id = (int) id;
+	  cpus[n].idle = idle;
+	  cpus[n].total = total;
+	}
+      n++;
+      p = (eol < end) ? eol + 1 : end;
+    }
+
+  /* unless the file ends there, the cpu lines must end in the buffer */
+  return (p < end || eof) ? (ssize_t) n : -1;
+}
+
+/*
+ * Read the cpu lines of the /proc/stat file 'fd' into '*cpus' (resized as
+ * needed), with the buffer '*buf' of '*size' bytes (likewise).  Returns
+ * the number of CPUs, the aggregated line included, or -1
+ */
+int
+cpustat_read (int fd, char **buf, size_t *size, struct cpustat_cpu **cpus,
+	      size_t *ncpus)
+{
+  struct cpustat_cpu *c;
+  ssize_t len, n;
+  char *b;
+
+  for (;;)
+    {
+      if (*size == 0 || *buf == NULL)
+	{
+	  if ((*buf = malloc (CPUSTAT_BUFSIZE)) == NULL)
+	    return -1;
+	  *size = CPUSTAT_BUFSIZE;
+	}
+      if ((len = pread (fd, *buf, *size, 0)) < 0)
+	return -1;
+
+      n = cpustat_parse (*buf, (size_t) len, (size_t) len < *size, *cpus,
+			 *ncpus);
+      if (n >= 0 && (size_t) n <= *ncpus)
+	return (int) n;
+      if (n > 0)
+	{
+	  /* more CPUs than expected: parse again in a larger array */
+	  if ((c = realloc (*cpus, (size_t) n * sizeof (*c))) == NULL)
+	    return -1;
+	  *cpus = c;
+	  *ncpus = (size_t) n;
+	  continue;
+	}
+      if ((b = realloc (*buf, *size * 2)) == NULL)
+	return -1;
+      *buf = b;
+      *size *= 2;
+    }
+}
+
+/*
+ * Check the idle percent since boot of every CPU listed in the /proc/stat
+ * file 'path'.
+ */
+int
+cpustat_check (const char *path, const thresholds * my_threshold)
+{
+  char *buf = NULL, upbuf[128];
+  struct cpustat_cpu *cpus = NULL;
+  size_t size = 0, ncpus = 0, i, min = 0, max = 0, n = 0;
+  double ticks, pct, min_pct = 0, max_pct = 0;
+  unsigned long long all_ticks = 0;
+  time_t uptime_secs = 0;
+  long hertz;
+  int fd, count, status, max_status;
+
+  if (strcmp (path, PROC_STAT) == 0
+      && (UPTIME_RET_FAIL == (uptime_secs = uptime ()) || uptime_secs == 0))
+    {
+      printf ("UPTIME UNKNOWN: can't get system uptime counter\n");
+      return STATE_UNKNOWN;
+    }
+  if ((hertz = sysconf (_SC_CLK_TCK)) <= 0)
+    hertz = 100;
+
+  if ((fd = open (path, O_RDONLY | O_CLOEXEC)) < 0
+      || (count = cpustat_read (fd, &buf, &size, &cpus, &ncpus)) < 0)
+    {
+      if (fd >= 0)
+	close (fd);
+      free (buf);
+      free (cpus);
+      printf ("UPTIME UNKNOWN: cannot read %s\n", path);
+      return STATE_UNKNOWN;
+    }
+  close (fd);
+
+  for (i = 0; i < (size_t) count; i++)
+    if (cpus[i].id < 0)
+      all_ticks = cpus[i].total;
+    else
+      n++;
+  if (uptime_secs == 0 && n > 0)
+    uptime_secs = (time_t) (all_ticks / n / (unsigned long long) hertz);
+  if (n == 0 || uptime_secs == 0)
+    {
+      free (buf);
+      free (cpus);
+      printf ("UPTIME UNKNOWN: no cpu found in %s\n", path);
+      return STATE_UNKNOWN;
+    }
+
+  ticks = (double) uptime_secs * (double) hertz;
+  for (i = 0, n = 0; i < (size_t) count; i++)
+    {
+      if (cpus[i].id < 0)
+	continue;
+      pct = 100.0 * (double) cpus[i].idle / ticks;
+      if (pct > 100.0)
+	pct = 100.0;
+      if (n == 0 || pct < min_pct)
+	{
+	  min_pct = pct;
+	  min = i;
+	}
+      if (n == 0 || pct > max_pct)
+	{
+	  max_pct = pct;
+	  max = i;
+	}
+      n++;
+    }
+
+  status = get_status (min_pct, my_threshold);
+  if ((max_status = get_status (max_pct, my_threshold)) > status)
+    status = max_status;
+
+  printf ("UPTIME %s: %lu cpus, idle min %.2f%% (cpu%d) max %.2f%% (cpu%d)"
+	  " in %s|idle_min=%.2f%% idle_max=%.2f%%",
+	  status_message (status),
+	  (unsigned long) n, min_pct, cpus[min].id, max_pct, cpus[max].id,
+	  sprint_uptime (upbuf, sizeof (upbuf), uptime_secs), min_pct,
+	  max_pct);
+  for (i = 0; i < (size_t) count; i++)
+    if (cpus[i].id >= 0)
+      {
+	pct = 100.0 * (double) cpus[i].idle / ticks;
+	printf (" 'cpu%d'=%.2f%%", cpus[i].id, (pct > 100.0) ? 100.0 : pct);
+      }
+  putchar ('\n');
+
+  free (buf);
+  free (cpus);
+
+  return status;
+}
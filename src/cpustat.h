@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stddef.h>
+#include <time.h>
+
+#include "nputils.h"
+
+#define PROC_STAT  "/proc/stat"
+
+struct cpustat_cpu
+{
+  int id;			/* -1 for the aggregated "cpu" line */
+  unsigned long long idle;	/* idle and iowait clock ticks */
+  unsigned long long total;	/* all the clock ticks */
+};
+
+int cpustat_read (int, char **, size_t *, struct cpustat_cpu **, size_t *);
+int cpustat_check (const char *, const thresholds *);
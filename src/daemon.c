@@ -0,0 +1,448 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Resident check_uptime server answering checks on a Unix socket
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Protocol: the client sends one line per check, made of the options
+ *   [-w|--warning RANGE] [-c|--critical RANGE]
+ * (the thresholds given to the daemon are used when omitted) and gets
+ * back the line that check_uptime would print.  All the requests read
+ * in the same poll() round share a single uptime() call.
+ *
+ * The socket loop, daemon_serve(), is shared with the process age daemon
+ * of procwatch.c: a struct daemon_handler gives it the answer callback.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "daemon.h"
+#include "netutils.h"
+#include "nputils.h"
+#include "uptime.h"
+
+#define DAEMON_MAX_CLIENTS  256
+#define DAEMON_LINE_SIZE    256
+
+struct client
+{
+  int fd;
+  size_t len;
+  char line[DAEMON_LINE_SIZE];
+  char *pending;		/* unsent part of the replies */
+  size_t pending_len;
+};
+
+static volatile sig_atomic_t daemon_quit = FALSE;
+
+static void
+daemon_signal_handler (int sig __attribute__ ((__unused__)))
+{
+  daemon_quit = TRUE;
+}
+
+/*
+ * Tokenize the request and update the thresholds given in it.
+ * Returns 0 if okay, otherwise -1
+ */
+int
+daemon_parse_request (char *request, char **warning, char **critical)
+{
+  char *token, *saveptr = NULL;
+  char **target;
+
+  for (token = strtok_r (request, " \t\r", &saveptr); token != NULL;
+       token = strtok_r (NULL, " \t\r", &saveptr))
+    {
+      if (!strcmp (token, "-w") || !strcmp (token, "--warning"))
+	target = warning;
+      else if (!strcmp (token, "-c") || !strcmp (token, "--critical"))
+	target = critical;
+      else if (!strncmp (token, "--warning=", 10))
+	{
+	  *warning = token + 10;
+	  continue;
+	}
+      else if (!strncmp (token, "--critical=", 11))
+	{
+	  *critical = token + 11;
+	  continue;
+	}
+      else
+	return -1;
+
+      if (NULL == (*target = strtok_r (NULL, " \t\r", &saveptr)))
+	return -1;
+    }
+
+  return 0;
+}
+
+/* the state of the plain uptime daemon */
+struct uptime_daemon
+{
+  char *warning, *critical;
+  time_t uptime_secs;
+  int have_uptime;
+};
+
+/* coalesce all the requests of a poll() round into one uptime read */
+static void
+uptime_round (int ready __attribute__ ((__unused__)), void *arg)
+{
+  struct uptime_daemon *ud = arg;
+
+  ud->have_uptime = FALSE;
+}
+
+static void
+uptime_answer (char *request, char *reply, size_t size, void *arg)
+{
+  struct uptime_daemon *ud = arg;
+  char *warning = ud->warning, *critical = ud->critical;
+  thresholds my_threshold;
+
+  if (!ud->have_uptime)
+    {
+      ud->uptime_secs = uptime ();
+      ud->have_uptime = TRUE;
+    }
+
+  if (UPTIME_RET_FAIL == ud->uptime_secs)
+    snprintf (reply, size, "UPTIME UNKNOWN: can't get system uptime counter");
+  else if (daemon_parse_request (request, &warning, &critical) < 0 ||
+	   set_thresholds (&my_threshold, warning, critical) != 0)
+    snprintf (reply, size, "UPTIME UNKNOWN: invalid request");
+  else
+    sprint_check_result (reply, size, ud->uptime_secs, &my_threshold);
+}
+
+/*
+ * Send 'reply' after the replies still pending, and save the part the
+ * socket did not accept.  Returns 0 if okay, otherwise -1
+ */
+static int
+send_reply (struct client *cl, const char *reply, size_t len)
+{
+  ssize_t n = 0;
+  char *pending;
+
+  if (NULL == cl->pending
+      && (n = send (cl->fd, reply, len, MSG_NOSIGNAL)) < 0)
+    {
+      if (errno != EAGAIN && errno != EINTR)
+	return -1;
+      n = 0;
+    }
+  if ((size_t) n == len)
+    return 0;
+
+  if (NULL == (pending = realloc (cl->pending, cl->pending_len + len - n)))
+    return -1;
+  memcpy (pending + cl->pending_len, reply + n, len - n);
+  cl->pending = pending;
+  cl->pending_len += len - n;
+
+  return 0;
+}
+
+static int
+flush_pending (struct client *cl)
+{
+  ssize_t n;
+
+  if ((n = send (cl->fd, cl->pending, cl->pending_len, MSG_NOSIGNAL)) < 0)
+    return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+
+  cl->pending_len -= n;
+  if (cl->pending_len > 0)
+    memmove (cl->pending, cl->pending + n, cl->pending_len);
+  else
+    {
+      free (cl->pending);
+      cl->pending = NULL;
+    }
+
+  return 0;
+}
+
+/*
+ * Read the data sent by a client and answer every complete line.
+ * Returns 0 if the connection must be kept open, otherwise -1
+ */
+static int
+serve_client (struct client *cl, const struct daemon_handler *handler)
+{
+  char reply[DAEMON_LINE_SIZE];
+  char *request, *eol;
+  ssize_t n;
+  size_t len;
+
+  n = read (cl->fd, cl->line + cl->len, sizeof (cl->line) - cl->len - 1);
+  if (n < 0)
+    return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+  if (n == 0)
+    return -1;
+
+  cl->len += n;
+  cl->line[cl->len] = '\0';
+
+  request = cl->line;
+  while (NULL != (eol = strchr (request, '\n')))
+    {
+      *eol = '\0';
+      handler->answer (request, reply, sizeof (reply) - 1, handler->arg);
+      len = strlen (reply);
+      reply[len++] = '\n';
+      if (send_reply (cl, reply, len) < 0)
+	return -1;
+      request = eol + 1;
+    }
+
+  cl->len -= request - cl->line;
+  memmove (cl->line, request, cl->len);
+
+  /* a request that does not fit in the buffer cannot be valid */
+  return (cl->len < sizeof (cl->line) - 1) ? 0 : -1;
+}
+
+/*
+ * Open the socket of the daemon: the one passed by systemd, if any, in
+ * which case '*socket_path' is set to NULL, otherwise a new one bound to
+ * '*socket_path'.  Returns the listening descriptor, or -1
+ */
+int
+daemon_listen (const char **socket_path)
+{
+  int listen_fd;
+
+  if ((listen_fd = net_socket_activation ()) >= 0)
+    {
+      *socket_path = NULL;
+      return listen_fd;
+    }
+  if (NULL == *socket_path)
+    {
+      fputs ("no socket given and not started by systemd\n", stderr);
+      return -1;
+    }
+  if ((listen_fd = net_listen_unix (*socket_path)) < 0)
+    perror (*socket_path);
+
+  return listen_fd;
+}
+
+/*
+ * Accept the clients on 'listen_fd' and answer their requests with
+ * 'handler' until SIGINT or SIGTERM, then close the socket and remove
+ * 'socket_path' (unless NULL).  Returns the exit code of the daemon
+ */
+int
+daemon_serve (int listen_fd, const char *socket_path,
+	      const struct daemon_handler *handler)
+{
+  struct pollfd pfd[DAEMON_MAX_CLIENTS + 2];
+  struct client *clients;
+  struct sigaction sa;
+  int i, j, fd, nfds = 2;
+
+  if (NULL == (clients = calloc (DAEMON_MAX_CLIENTS + 2, sizeof (*clients))))
+    {
+      perror ("cannot allocate memory");
+      close (listen_fd);
+      if (socket_path)
+	unlink (socket_path);
+      return STATE_UNKNOWN;
+    }
+
+  memset (&sa, 0, sizeof (sa));
+  sa.sa_handler = daemon_signal_handler;
+  sigaction (SIGINT, &sa, NULL);
+  sigaction (SIGTERM, &sa, NULL);
+  signal (SIGPIPE, SIG_IGN);
+
+  pfd[0].fd = listen_fd;
+  pfd[0].events = POLLIN;
+  pfd[1].fd = handler->fd;	/* poll() ignores a negative descriptor */
+  pfd[1].events = POLLIN;
+  pfd[1].revents = 0;
+
+  while (!daemon_quit)
+    {
+      if (poll (pfd, nfds, -1) < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  perror ("poll");
+	  break;
+	}
+
+      if (handler->round)
+	handler->round (handler->fd >= 0
+			&& (pfd[1].revents & (POLLIN | POLLERR)),
+			handler->arg);
+
+      /* the requests of a client are not read until it has read the
+         replies already sent */
+      for (i = 2; i < nfds; i++)
+	{
+	  int ret = 0;
+
+	  if (clients[i].pending)
+	    {
+	      if (pfd[i].revents & (POLLOUT | POLLHUP | POLLERR))
+		ret = flush_pending (&clients[i]);
+	    }
+	  else if (pfd[i].revents & (POLLIN | POLLHUP | POLLERR))
+	    ret = serve_client (&clients[i], handler);
+	  if (ret < 0)
+	    {
+	      close (pfd[i].fd);
+	      free (clients[i].pending);
+	      pfd[i].fd = -1;
+	    }
+	  else
+	    pfd[i].events = clients[i].pending ? POLLOUT : POLLIN;
+	}
+
+      if (pfd[0].revents & POLLIN)
+	while (nfds < DAEMON_MAX_CLIENTS + 2 &&
+	       (fd = accept (listen_fd, NULL, NULL)) >= 0)
+	  {
+	    net_set_nonblock (fd);
+	    pfd[nfds].fd = fd;
+	    pfd[nfds].events = POLLIN;
+	    pfd[nfds].revents = 0;
+	    memset (&clients[nfds], 0, sizeof (struct client));
+	    clients[nfds].fd = fd;
+	    nfds++;
+	  }
+
+      /* drop the closed connections */
+      for (i = j = 2; i < nfds; i++)
+	if (pfd[i].fd >= 0)
+	  {
+	    if (i != j)
+	      {
+		pfd[j] = pfd[i];
+		clients[j] = clients[i];
+	      }
+	    j++;
+	  }
+      nfds = j;
+      pfd[0].events = (nfds < DAEMON_MAX_CLIENTS + 2) ? POLLIN : 0;
+    }
+
+  for (i = 2; i < nfds; i++)
+    {
+      close (pfd[i].fd);
+      free (clients[i].pending);
+    }
+  close (listen_fd);
+  if (socket_path)
+    unlink (socket_path);
+  free (clients);
+
+  return STATE_OK;
+}
+
+int
+uptime_daemon (const char *socket_path, char *warning, char *critical)
+{
+  struct uptime_daemon ud;
+  struct daemon_handler handler;
+  int listen_fd;
+
+  if ((listen_fd = daemon_listen (&socket_path)) < 0)
+    return STATE_UNKNOWN;
+
+  memset (&ud, 0, sizeof (ud));
+  ud.warning = warning;
+  ud.critical = critical;
+  handler.fd = -1;
+  handler.round = uptime_round;
+  handler.answer = uptime_answer;
+  handler.arg = &ud;
+
+  return daemon_serve (listen_fd, socket_path, &handler);
+}
+
+/*
+ * Ask a running daemon for a check and print its answer.
+ * Returns the Nagios state of the check
+ */
+int
+uptime_client (const char *socket_path, const char *warning,
+	       const char *critical)
+{
+  char line[DAEMON_LINE_SIZE];
+  size_t len = 0;
+  ssize_t n;
+  int fd;
+
+  if ((fd = net_connect_unix (socket_path)) < 0)
+    {
+      printf ("UPTIME UNKNOWN: cannot connect to %s\n", socket_path);
+      return STATE_UNKNOWN;
+    }
+
+  n = snprintf (line, sizeof (line), "%s%s %s%s\n",
+		warning ? "-w " : "", warning ? warning : "",
+		critical ? "-c " : "", critical ? critical : "");
+  if (n >= (ssize_t) sizeof (line) || write (fd, line, n) != n)
+    {
+      close (fd);
+      printf ("UPTIME UNKNOWN: cannot send the request\n");
+      return STATE_UNKNOWN;
+    }
+
+  while (len < sizeof (line) - 1 &&
+	 (n = read (fd, line + len, sizeof (line) - 1 - len)) > 0)
+    {
+      len += n;
+      if (line[len - 1] == '\n')
+	break;
+    }
+  close (fd);
+  line[len] = '\0';
+
+  if (len == 0 || line[len - 1] != '\n')
+    {
+      printf ("UPTIME UNKNOWN: no answer from the daemon\n");
+      return STATE_UNKNOWN;
+    }
+
+  fputs (line, stdout);
+
+  if (!strncmp (line, "UPTIME OK:", 10))
+    return STATE_OK;
+  else if (!strncmp (line, "UPTIME WARNING:", 15))
+    return STATE_WARNING;
+  else if (!strncmp (line, "UPTIME CRITICAL:", 16))
+    return STATE_CRITICAL;
+  return STATE_UNKNOWN;
+}
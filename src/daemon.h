@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stddef.h>
+
+/* what a daemon does with its requests */
+struct daemon_handler
+{
+  int fd;			/* another descriptor to poll, or -1 */
+  /* called after every poll(), before the requests, 'ready' telling if
+     'fd' can be read; may be NULL */
+  void (*round) (int ready, void *arg);
+  /* write in 'reply' the answer line to 'request', without the newline */
+  void (*answer) (char *request, char *reply, size_t size, void *arg);
+  void *arg;
+};
+
+int uptime_daemon (const char *, char *, char *);
+int uptime_client (const char *, const char *, const char *);
+int daemon_parse_request (char *, char **, char **);
+int daemon_listen (const char **);
+int daemon_serve (int, const char *, const struct daemon_handler *);
@@ -0,0 +1,621 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Fleet aggregation of the uptime snapshots of many hosts
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The snapshots are lines "HOST UPTIME_SECONDS [GROUP]", in a file or in
+ * all the files of a directory.  For every group (the hosts without one
+ * are in the group "all") the hosts are counted, as are the ones rebooted
+ * within the --reboots-since window, and the uptimes are added to a
+ * sketch: a histogram with 64 exact buckets below 64 seconds and 64
+ * buckets for each power of two above, so a quantile is known within 1%
+ * in 30 KB per group whatever the number of hosts.  Two sketches are
+ * merged by adding their buckets.
+ *
+ * A snapshot was taken when its file was last written: the age of the
+ * file (now - st_mtime) is added to the uptimes it holds.  Every record
+ * counts as one host, so the relay must keep a single file per source,
+ * replaced rather than appended to another one, or a host found in two
+ * files is counted twice.
+ *
+ * The files are split in chunks of FLEET_CHUNK bytes taken by --threads
+ * threads; each thread fills its own groups, merged at the end.  A chunk
+ * is read with pread(), with up to FLEET_LINE_MAX more bytes to finish its
+ * last line, rather than mapped: the relay may truncate a file in place
+ * while it is read, which would raise SIGBUS on a mapping but only
+ * shortens a read.  The parser does not use stdio nor allocate memory.
+ */
+
+#include "config.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include "fleet.h"
+#include "nputils.h"
+#include "procscan.h"
+#include "uptime.h"
+
+#define FLEET_CHUNK       (4 << 20)
+#define FLEET_LINE_MAX    4096	/* read past a chunk to end its last line */
+#define FLEET_MAX_GROUPS  256
+#define FLEET_DEFAULT_GROUP  "all"
+
+/* the errors of a worker */
+#define FLEET_ERR_GROUPS  1	/* more than FLEET_MAX_GROUPS groups */
+#define FLEET_ERR_READ    2
+
+struct fleet_group
+{
+  char name[FLEET_GROUP_LEN];
+  size_t len;
+  uint64_t rebooted;		/* uptime below the window */
+  struct fleet_sketch sketch;
+};
+
+struct fleet_file
+{
+  char *name;			/* relative to the directory of the scan */
+  uint64_t age;			/* seconds since the snapshot */
+};
+
+struct fleet_chunk
+{
+  size_t file;
+  off_t offset;
+  size_t size;
+};
+
+struct fleet_worker
+{
+  struct fleet_scan *scan;
+  struct fleet_group *groups[FLEET_MAX_GROUPS];
+  size_t ngroups;
+  unsigned long invalid;
+  int error;			/* FLEET_ERR_* bits */
+  char *buf;			/* FLEET_CHUNK + FLEET_LINE_MAX + 1 bytes */
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+  pthread_t tid;
+  int threaded;
+#endif
+};
+
+struct fleet_scan
+{
+  int dirfd;			/* the directory of the files, or AT_FDCWD */
+  struct fleet_file *files;
+  size_t nfiles;
+  struct fleet_chunk *chunks;
+  size_t nchunks;
+  size_t next;			/* first chunk not taken yet */
+  uint64_t window;
+};
+
+static unsigned int
+fleet_bucket (uint64_t value)
+{
+  unsigned int exp;
+
+  if (value < (1U << FLEET_SUB_BITS))
+    return (unsigned int) value;
+  exp = 63 - (unsigned int) __builtin_clzll (value);
+  return ((exp - FLEET_SUB_BITS + 1) << FLEET_SUB_BITS)
+    + (unsigned int) ((value >> (exp - FLEET_SUB_BITS))
+		      & ((1U << FLEET_SUB_BITS) - 1));
+}
+
+/* The middle of the values falling in 'bucket' */
+static uint64_t
+fleet_bucket_value (unsigned int bucket)
+{
+  unsigned int exp, shift;
+  uint64_t low;
+
+  if (bucket < (1U << FLEET_SUB_BITS))
+    return bucket;
+  exp = (bucket >> FLEET_SUB_BITS) + FLEET_SUB_BITS - 1;
+  shift = exp - FLEET_SUB_BITS;
+  low = ((uint64_t) (bucket & ((1U << FLEET_SUB_BITS) - 1))
+	 | (1U << FLEET_SUB_BITS)) << shift;
+  return low + (((uint64_t) 1 << shift) >> 1);
+}
+
+void
+fleet_sketch_add (struct fleet_sketch *sketch, uint64_t value)
+{
+  if (sketch->count == 0 || value < sketch->min)
+    sketch->min = value;
+  if (sketch->count == 0 || value > sketch->max)
+    sketch->max = value;
+  sketch->count++;
+  sketch->buckets[fleet_bucket (value)]++;
+}
+
+void
+fleet_sketch_merge (struct fleet_sketch *dst, const struct fleet_sketch *src)
+{
+  unsigned int i;
+
+  if (src->count == 0)
+    return;
+  if (dst->count == 0 || src->min < dst->min)
+    dst->min = src->min;
+  if (dst->count == 0 || src->max > dst->max)
+    dst->max = src->max;
+  dst->count += src->count;
+  for (i = 0; i < FLEET_BUCKETS; i++)
+    dst->buckets[i] += src->buckets[i];
+}
+
+/* The 'q' percentile (0-100) of the values added to 'sketch' */
+uint64_t
+fleet_sketch_quantile (const struct fleet_sketch * sketch, double q)
+{
+  uint64_t rank, seen = 0, value;
+  double r = q / 100.0 * (double) sketch->count;
+  unsigned int i;
+
+  if (sketch->count == 0)
+    return 0;
+  /* the nearest rank, counted from zero */
+  rank = (uint64_t) r;
+  if ((double) rank < r)
+    rank++;
+  if (rank > 0)
+    rank--;
+  if (rank >= sketch->count)
+    return sketch->max;
+
+  for (i = 0; i < FLEET_BUCKETS; i++)
+    if ((seen += sketch->buckets[i]) > rank)
+      break;
+  value = fleet_bucket_value (i);
+  if (value < sketch->min)
+    return sketch->min;
+  return (value > sketch->max) ? sketch->max : value;
+}
+
+static struct fleet_group *
+fleet_group (struct fleet_worker *w, const char *name, size_t len)
+{
+  struct fleet_group *g;
+  size_t i;
+
+  if (len >= FLEET_GROUP_LEN)
+    len = FLEET_GROUP_LEN - 1;
+  for (i = 0; i < w->ngroups; i++)
+    if (w->groups[i]->len == len && memcmp (w->groups[i]->name, name, len)
+	== 0)
+      return w->groups[i];
+
+  if (w->ngroups == FLEET_MAX_GROUPS
+      || (g = calloc (1, sizeof (struct fleet_group))) == NULL)
+    {
+      w->error |= FLEET_ERR_GROUPS;
+      return NULL;
+    }
+  memcpy (g->name, name, len);
+  g->len = len;
+  w->groups[w->ngroups++] = g;
+
+  return g;
+}
+
+/*
+ * Add the lines of [p, end), whose uptimes are 'age' seconds old, to the
+ * groups of 'w'.  The last line may go past 'end', up to 'limit'
+ */
+static void
+fleet_parse (struct fleet_worker *w, const char *p, const char *end,
+	     const char *limit, uint64_t age, uint64_t window)
+{
+  struct fleet_group *last = NULL, *g;
+  const char *line, *group;
+  uint64_t value;
+  size_t len;
+
+  while (p < end)
+    {
+      /* the empty lines and the comments are skipped */
+      line = p;
+      if (*p == '\n' || *p == '#')
+	{
+	  while (p < limit && *p++ != '\n')
+	    ;
+	  continue;
+	}
+
+      /* the host name */
+      while (p < limit && *p != ' ' && *p != '\t' && *p != '\n')
+	p++;
+      while (p < limit && (*p == ' ' || *p == '\t'))
+	p++;
+
+      /* the uptime, its decimals are ignored */
+      value = 0;
+      group = p;
+      while (p < limit && *p >= '0' && *p <= '9')
+	value = value * 10 + (uint64_t) (*p++ - '0');
+      if (p == group || p == line)
+	{
+	  w->invalid++;
+	  while (p < limit && *p++ != '\n')
+	    ;
+	  continue;
+	}
+      if (p < limit && *p == '.')
+	while (++p < limit && *p >= '0' && *p <= '9')
+	  ;
+      while (p < limit && (*p == ' ' || *p == '\t'))
+	p++;
+
+      /* the optional group */
+      group = p;
+      while (p < limit && *p != ' ' && *p != '\t' && *p != '\n'
+	     && *p != '\r')
+	p++;
+      len = (size_t) (p - group);
+      if (len == 0)
+	{
+	  group = FLEET_DEFAULT_GROUP;
+	  len = sizeof (FLEET_DEFAULT_GROUP) - 1;
+	}
+      while (p < limit && *p++ != '\n')
+	;
+
+      /* the hosts of a group are usually in a row */
+      if (last && last->len == len && memcmp (last->name, group, len) == 0)
+	g = last;
+      else if ((g = fleet_group (w, group, len)) == NULL)
+	return;
+      last = g;
+
+      value += age;
+      fleet_sketch_add (&g->sketch, value);
+      if (value < window)
+	g->rebooted++;
+    }
+}
+
+/*
+ * Read 'size' bytes at 'offset' of 'fd' into 'buf'.  Returns the number
+ * of bytes read, less at the end of the file, or -1
+ */
+static ssize_t
+fleet_pread (int fd, char *buf, size_t size, off_t offset)
+{
+  size_t done = 0;
+  ssize_t n;
+
+  while (done < size)
+    {
+      if ((n = pread (fd, buf + done, size - done, offset + (off_t) done))
+	  < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  return -1;
+	}
+      if (n == 0)
+	break;
+      done += (size_t) n;
+    }
+
+  return (ssize_t) done;
+}
+
+/*
+ * Read and parse a chunk.  The line crossing its start belongs to the
+ * previous chunk, the one crossing its end to this one.  Returns 0 if
+ * okay, the file having possibly been shortened or removed meanwhile
+ */
+static int
+fleet_read_chunk (struct fleet_worker *w, const struct fleet_chunk *c)
+{
+  struct fleet_scan *scan = w->scan;
+  const struct fleet_file *f = &scan->files[c->file];
+  const char *p, *end, *limit;
+  size_t before = (c->offset > 0) ? 1 : 0;
+  ssize_t len;
+  int fd;
+
+  if ((fd = openat (scan->dirfd, f->name, O_RDONLY | O_CLOEXEC)) < 0)
+    return (errno == ENOENT) ? 0 : -1;
+  len = fleet_pread (fd, w->buf, before + c->size + FLEET_LINE_MAX,
+		     c->offset - (off_t) before);
+  close (fd);
+  if (len < 0)
+    return -1;
+  if ((size_t) len <= before)
+    return 0;
+
+  p = w->buf + before;
+  limit = w->buf + len;
+  end = ((size_t) len < before + c->size) ? limit : p + c->size;
+  if (before && w->buf[0] != '\n')
+    while (p < end && *p++ != '\n')
+      ;
+  fleet_parse (w, p, end, limit, f->age, scan->window);
+
+  return 0;
+}
+
+static void *
+fleet_work (void *arg)
+{
+  struct fleet_worker *w = arg;
+  struct fleet_scan *scan = w->scan;
+  size_t i;
+
+  while (!w->error
+	 && (i = __atomic_fetch_add (&scan->next, 1, __ATOMIC_RELAXED))
+	 < scan->nchunks)
+    if (fleet_read_chunk (w, &scan->chunks[i]) < 0)
+      w->error |= FLEET_ERR_READ;
+
+  return NULL;
+}
+
+/* Add the file 'name' and its chunks to 'scan'.  Returns 0 if okay */
+static int
+fleet_add_file (struct fleet_scan *scan, const char *name, time_t now)
+{
+  struct fleet_file *f;
+  struct fleet_chunk *c;
+  struct stat st;
+  off_t off;
+  size_t n;
+
+  if (fstatat (scan->dirfd, name, &st, 0) < 0)
+    return (errno == ENOENT) ? 0 : -1;
+  if (!S_ISREG (st.st_mode) || st.st_size == 0)
+    return 0;
+
+  n = ((size_t) st.st_size + FLEET_CHUNK - 1) / FLEET_CHUNK;
+  if ((f = realloc (scan->files, (scan->nfiles + 1) * sizeof (*f))) == NULL)
+    return -1;
+  scan->files = f;
+  if ((c = realloc (scan->chunks, (scan->nchunks + n) * sizeof (*c)))
+      == NULL)
+    return -1;
+  scan->chunks = c;
+  if ((f[scan->nfiles].name = strdup (name)) == NULL)
+    return -1;
+  f[scan->nfiles].age = (now > st.st_mtime) ?
+    (uint64_t) (now - st.st_mtime) : 0;
+
+  for (off = 0; off < st.st_size; off += FLEET_CHUNK)
+    {
+      c[scan->nchunks].file = scan->nfiles;
+      c[scan->nchunks].offset = off;
+      c[scan->nchunks].size = (off + FLEET_CHUNK < st.st_size) ?
+	FLEET_CHUNK : (size_t) (st.st_size - off);
+      scan->nchunks++;
+    }
+  scan->nfiles++;
+
+  return 0;
+}
+
+/* List the file 'path', or all the files of the directory 'path' */
+static int
+fleet_add_path (struct fleet_scan *scan, const char *path)
+{
+  struct dirent *ent;
+  struct stat st;
+  DIR *dir;
+  time_t now = time (NULL);
+  int ret = 0, fd;
+
+  scan->dirfd = AT_FDCWD;
+  if (stat (path, &st) < 0)
+    return -1;
+  if (!S_ISDIR (st.st_mode))
+    return fleet_add_file (scan, path, now);
+
+  /* the files are opened again by the threads, relative to 'fd' */
+  if ((fd = open (path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
+    return -1;
+  scan->dirfd = fd;
+  if ((fd = dup (fd)) < 0)
+    return -1;
+  if ((dir = fdopendir (fd)) == NULL)
+    {
+      close (fd);
+      return -1;
+    }
+  while (ret == 0 && (ent = readdir (dir)) != NULL)
+    if (ent->d_name[0] != '.')
+      ret = fleet_add_file (scan, ent->d_name, now);
+  closedir (dir);
+
+  return ret;
+}
+
+static int
+fleet_cmp (const void *a, const void *b)
+{
+  return strcmp ((*(struct fleet_group * const *) a)->name,
+		 (*(struct fleet_group * const *) b)->name);
+}
+
+/*
+ * Check the 'quantile' percentile of the uptimes, and the percent of the
+ * hosts rebooted in the last 'window' seconds ('window_str' in the
+ * output), of every group of the snapshots in 'path', read with 'threads'
+ * threads.
+ */
+int
+fleet_check (const char *path, unsigned int threads, double quantile,
+	     const char *window_str, time_t window,
+	     const thresholds * my_threshold,
+	     const thresholds * reboot_threshold)
+{
+  char buf[128];
+  struct fleet_scan scan;
+  struct fleet_worker workers[PROCSCAN_MAX_THREADS], *merged;
+  unsigned long count[STATE_UNKNOWN + 1] = { 0 }, invalid = 0;
+  uint64_t hosts = 0, q, worst_q = 0, rebooted = 0;
+  size_t i, j, worst = 0;
+  double percent;
+  int status = STATE_OK, group_status, worst_status = -1, ret, err = 0;
+
+  memset (&scan, 0, sizeof (scan));
+  scan.window = (uint64_t) window;
+  ret = fleet_add_path (&scan, path);
+
+#if !(HAVE_PTHREAD_H && HAVE_PTHREAD)
+  threads = 1;
+#endif
+  if (threads < 1)
+    threads = 1;
+  if (threads > PROCSCAN_MAX_THREADS)
+    threads = PROCSCAN_MAX_THREADS;
+  memset (workers, 0, sizeof (workers));
+  for (i = 0; i < threads; i++)
+    {
+      workers[i].scan = &scan;
+      if (ret == 0 && (workers[i].buf = malloc (FLEET_CHUNK + FLEET_LINE_MAX
+						+ 1)) == NULL)
+	ret = -1;
+    }
+
+  /* the chunks left by a thread that failed to start are taken by the
+     others */
+  if (ret == 0)
+    {
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+      for (i = 1; i < threads; i++)
+	workers[i].threaded = (pthread_create (&workers[i].tid, NULL,
+					       fleet_work, &workers[i]) == 0);
+#endif
+      fleet_work (&workers[0]);
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+      for (i = 1; i < threads; i++)
+	if (workers[i].threaded)
+	  pthread_join (workers[i].tid, NULL);
+#endif
+    }
+
+  /* the groups of the other threads are merged in the first one */
+  merged = &workers[0];
+  for (i = 0; i < threads; i++)
+    {
+      invalid += workers[i].invalid;
+      err |= workers[i].error;
+      for (j = 0; i > 0 && j < workers[i].ngroups; j++)
+	{
+	  struct fleet_group *g = workers[i].groups[j], *m;
+
+	  if ((m = fleet_group (merged, g->name, g->len)) != NULL)
+	    {
+	      fleet_sketch_merge (&m->sketch, &g->sketch);
+	      m->rebooted += g->rebooted;
+	    }
+	  free (g);
+	}
+      free (workers[i].buf);
+    }
+  err |= merged->error;
+
+  for (i = 0; i < scan.nfiles; i++)
+    free (scan.files[i].name);
+  free (scan.files);
+  free (scan.chunks);
+  if (scan.dirfd >= 0)
+    close (scan.dirfd);
+
+  if (ret < 0 || err || merged->ngroups == 0)
+    {
+      if (ret < 0 || (err & FLEET_ERR_READ))
+	printf ("UPTIME UNKNOWN: cannot read %s\n", path);
+      else if (err)
+	printf ("UPTIME UNKNOWN: too many groups in %s (max %d)\n", path,
+		FLEET_MAX_GROUPS);
+      else
+	printf ("UPTIME UNKNOWN: no uptime record in %s\n", path);
+      for (i = 0; i < merged->ngroups; i++)
+	free (merged->groups[i]);
+      return STATE_UNKNOWN;
+    }
+
+  qsort (merged->groups, merged->ngroups, sizeof (merged->groups[0]),
+	 fleet_cmp);
+  for (i = 0; i < merged->ngroups; i++)
+    {
+      struct fleet_group *g = merged->groups[i];
+
+      q = fleet_sketch_quantile (&g->sketch, quantile);
+      percent = 100.0 * (double) g->rebooted / (double) g->sketch.count;
+      group_status = get_status ((double) (q / 60), my_threshold);
+      ret = get_status (percent, reboot_threshold);
+      if (ret > group_status)
+	group_status = ret;
+      count[group_status]++;
+      if (group_status > status)
+	status = group_status;
+      /* the worst group, or the one with the lowest uptimes */
+      if (group_status > worst_status
+	  || (group_status == worst_status && q < worst_q))
+	{
+	  worst_status = group_status;
+	  worst_q = q;
+	  worst = i;
+	}
+      hosts += g->sketch.count;
+      rebooted += g->rebooted;
+    }
+
+  printf ("UPTIME %s: %llu hosts in %lu groups, %lu warning, %lu critical, "
+	  "%s p%g %s, %.2f%% rebooted in %s|",
+	  status_message (status),
+	  (unsigned long long) hosts, (unsigned long) merged->ngroups,
+	  count[STATE_WARNING], count[STATE_CRITICAL],
+	  merged->groups[worst]->name, quantile,
+	  sprint_uptime (buf, sizeof (buf), (time_t) worst_q),
+	  100.0 * (double) merged->groups[worst]->rebooted /
+	  (double) merged->groups[worst]->sketch.count, window_str);
+
+  /* per group: hosts, uptime percentile in minutes, percent rebooted */
+  for (i = 0; i < merged->ngroups; i++)
+    {
+      struct fleet_group *g = merged->groups[i];
+
+      printf ("'%s_hosts'=%llu '%s_p%g'=%llu '%s_rebooted'=%.2f%% ",
+	      g->name, (unsigned long long) g->sketch.count, g->name,
+	      quantile, (unsigned long long)
+	      (fleet_sketch_quantile (&g->sketch, quantile) / 60), g->name,
+	      100.0 * (double) g->rebooted / (double) g->sketch.count);
+      free (g);
+    }
+  printf ("invalid=%lu\n", invalid);
+
+  return status;
+}
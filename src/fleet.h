@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+#include "nputils.h"
+
+/* 64 exact buckets, then 64 buckets for each power of two up to 2^63 */
+#define FLEET_SUB_BITS  6
+#define FLEET_BUCKETS   ((64 - FLEET_SUB_BITS + 1) << FLEET_SUB_BITS)
+#define FLEET_GROUP_LEN 64
+
+struct fleet_sketch
+{
+  uint64_t count;
+  uint64_t min, max;
+  uint64_t buckets[FLEET_BUCKETS];
+};
+
+void fleet_sketch_add (struct fleet_sketch *, uint64_t);
+void fleet_sketch_merge (struct fleet_sketch *, const struct fleet_sketch *);
+uint64_t fleet_sketch_quantile (const struct fleet_sketch *, double);
+int fleet_check (const char *, unsigned int, double, const char *, time_t,
+		 const thresholds *, const thresholds *);
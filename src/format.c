@@ -0,0 +1,206 @@
+/*
+ * License: GPL
+ * Copyright (c) 2010,2012,2013 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Functions formatting the system uptime and the plugin output
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#include "nputils.h"
+#include "probes.h"
+#include "uptime.h"
+
+#define BUFSIZE 127
+
+/* Returns the name of the Nagios state 'status' */
+const char *
+status_message (int status)
+{
+  switch (status)
+    {
+    case STATE_UNKNOWN:
+      return "UNKNOWN";
+    case STATE_CRITICAL:
+      return "CRITICAL";
+    case STATE_WARNING:
+      return "WARNING";
+    default:
+      return "OK";
+    }
+}
+
+char *
+sprint_uptime (char *buf, size_t size, time_t uptime_secs)
+{
+  unsigned int upminutes, uphours, updays;
+  size_t pos = 0;
+
+  UPTIME_PROBE1 (format__entry, (long long) uptime_secs);
+  updays = (unsigned int) (uptime_secs / (60 * 60 * 24));
+  if (updays)
+    pos +=
+      snprintf (buf, size, "%u day%s ", updays, (updays != 1) ? "s" : "");
+  if (pos >= size)
+    {
+      UPTIME_PROBE1 (format__return, buf);
+      return buf;
+    }
+  upminutes = (unsigned int) (uptime_secs / 60);
+  uphours = upminutes / 60;
+  uphours = uphours % 24;
+  upminutes = upminutes % 60;
+
+  if (uphours)
+    {
+      pos +=
+	snprintf (buf + pos, size - pos, "%u hour%s %u min", uphours,
+		  (uphours != 1) ? "s" : "", upminutes);
+    }
+  else
+    pos += snprintf (buf + pos, size - pos, "%u min", upminutes);
+  UPTIME_PROBE1 (format__return, buf);
+
+  return buf;
+}
+
+/*
+ * Format the plugin output line (message and perfdata) for 'uptime_secs'
+ * checked against 'my_threshold' and set '*status' to the resulting Nagios
+ * state.  Returns the length of the whole line: it has been truncated if
+ * not less than 'size'
+ */
+size_t
+sprint_check_line (char *line, size_t size, time_t uptime_secs,
+		   const thresholds * my_threshold, int *status)
+{
+  char buf[BUFSIZE + 1];
+  unsigned int uptime_mins;
+  int len;
+
+  uptime_mins = (unsigned int) (uptime_secs / 60);
+  *status = get_status (uptime_mins, my_threshold);
+
+  len = snprintf (line, size, "UPTIME %s: %s|uptime=%u",
+		  status_message (*status),
+		  sprint_uptime (buf, sizeof (buf), uptime_secs), uptime_mins);
+
+  return (len > 0) ? (size_t) len : 0;
+}
+
+/*
+ * Same as sprint_check_line(), returning the Nagios state
+ */
+int
+sprint_check_result (char *line, size_t size, time_t uptime_secs,
+		     const thresholds * my_threshold)
+{
+  int status;
+
+  sprint_check_line (line, size, uptime_secs, my_threshold, &status);
+
+  return status;
+}
+
+/*
+ * Same as sprint_check_result() with the number of reboots in the time
+ * window 'window' checked against 'reboot_threshold': the worse of the
+ * two states is returned.  With 'at_least' the number is a lower bound
+ */
+int
+sprint_reboots_result (char *line, size_t size, time_t uptime_secs,
+		       unsigned int reboots, int at_least, const char *window,
+		       const thresholds * my_threshold,
+		       const thresholds * reboot_threshold)
+{
+  char buf[BUFSIZE + 1];
+  int status, reboot_status;
+  unsigned int uptime_mins;
+
+  uptime_mins = (unsigned int) (uptime_secs / 60);
+  status = get_status (uptime_mins, my_threshold);
+  reboot_status = get_status (reboots, reboot_threshold);
+  if (reboot_status > status)
+    status = reboot_status;
+
+  snprintf (line, size,
+	    "UPTIME %s: %s, %s%u reboot%s in %s|uptime=%u reboots=%u",
+	    status_message (status),
+	    sprint_uptime (buf, sizeof (buf), uptime_secs),
+	    at_least ? "at least " : "", reboots, (reboots != 1) ? "s" : "",
+	    window, uptime_mins, reboots);
+
+  return status;
+}
+
+/*
+ * Check the age in minutes of each of the 'n' targets against
+ * 'my_threshold' and print the result line: the number of 'what' and of
+ * targets in each state, the youngest and the age of every target in the
+ * perfdata.  A target whose age could not be read is UNKNOWN, and so is
+ * the check.  Returns the Nagios state
+ */
+int
+print_age_targets (const char *what, const struct age_target *targets,
+		   size_t n, const thresholds * my_threshold)
+{
+  char buf[BUFSIZE + 1];
+  unsigned long count[STATE_UNKNOWN + 1] = { 0 };
+  size_t i, youngest = n;
+  int status = STATE_OK, target_status;
+  const char *sep = "";
+
+  for (i = 0; i < n; i++)
+    {
+      if (targets[i].error)
+	{
+	  count[STATE_UNKNOWN]++;
+	  continue;
+	}
+      target_status =
+	get_status ((unsigned int) (targets[i].age / 60), my_threshold);
+      count[target_status]++;
+      if (target_status > status)
+	status = target_status;
+      if (youngest == n || targets[i].age < targets[youngest].age)
+	youngest = i;
+    }
+  if (count[STATE_UNKNOWN] > 0)
+    status = STATE_UNKNOWN;
+
+  printf ("UPTIME %s: %lu %s, %lu warning, %lu critical, %lu unknown",
+	  status_message (status), (unsigned long) n, what,
+	  count[STATE_WARNING], count[STATE_CRITICAL], count[STATE_UNKNOWN]);
+  if (youngest < n)
+    printf (", youngest %s %s", targets[youngest].name,
+	    sprint_uptime (buf, sizeof (buf), targets[youngest].age));
+
+  /* one perfdata label per target, the age in minutes */
+  putchar ('|');
+  for (i = 0; i < n; i++)
+    if (!targets[i].error)
+      {
+	printf ("%s'%s'=%u", sep, targets[i].name,
+		(unsigned int) (targets[i].age / 60));
+	sep = " ";
+      }
+  putchar ('\n');
+
+  return status;
+}
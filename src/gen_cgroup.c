@@ -0,0 +1,143 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Generator of synthetic cgroup v2 trees for the --cgroup-root benchmark
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Usage: gen_cgroup [-n COUNT] [-p PER_POD] DIR
+ *
+ * Creates COUNT container cgroups (10000 by default), PER_POD (4) in each
+ * DIR/kubepods/podN directory, as a cgroup v2 tree laid out by the
+ * kubelet.  The creation time of container M of pod N, the modification
+ * time of its cgroup.controllers file, is set (N * 7 + M) % 10080 minutes
+ * in the past.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nputils.h"
+
+static const char *cgroup_files[] = {
+  "cgroup.controllers", "cgroup.procs", "cgroup.events", "cpu.max",
+  "memory.max", "memory.current", NULL
+};
+
+static int
+make_dir (const char *path)
+{
+  if (mkdir (path, 0755) < 0 && errno != EEXIST)
+    {
+      perror (path);
+      return -1;
+    }
+  return 0;
+}
+
+/* Create the interface files of the cgroup 'dir' */
+static int
+make_cgroup (const char *dir, time_t created)
+{
+  char path[4096];
+  struct timespec times[2];
+  int i, fd;
+
+  if (make_dir (dir) < 0)
+    return -1;
+  for (i = 0; cgroup_files[i]; i++)
+    {
+      snprintf (path, sizeof (path), "%s/%s", dir, cgroup_files[i]);
+      if ((fd = open (path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0
+	  || close (fd) < 0)
+	{
+	  perror (path);
+	  return -1;
+	}
+    }
+
+  snprintf (path, sizeof (path), "%s/%s", dir, cgroup_files[0]);
+  times[0].tv_sec = times[1].tv_sec = created;
+  times[0].tv_nsec = times[1].tv_nsec = 0;
+  if (utimensat (AT_FDCWD, path, times, 0) < 0)
+    {
+      perror (path);
+      return -1;
+    }
+
+  return 0;
+}
+
+int
+main (int argc, char **argv)
+{
+  char path[4096];
+  unsigned long i, count = 10000, per_pod = 4;
+  time_t now = time (NULL);
+  int c;
+
+  while ((c = getopt (argc, argv, "n:p:")) != -1)
+    switch (c)
+      {
+      case 'n':
+	count = strtoul (optarg, NULL, 10);
+	break;
+      case 'p':
+	per_pod = strtoul (optarg, NULL, 10);
+	break;
+      default:
+	count = 0;
+	break;
+      }
+
+  if (optind != argc - 1 || count == 0 || per_pod == 0)
+    {
+      fprintf (stderr, "Usage: %s [-n COUNT] [-p PER_POD] DIR\n", argv[0]);
+      return STATE_UNKNOWN;
+    }
+
+  if (make_cgroup (argv[optind], now - 86400) < 0)
+    return STATE_UNKNOWN;
+  snprintf (path, sizeof (path), "%s/kubepods", argv[optind]);
+  if (make_cgroup (path, now - 86400) < 0)
+    return STATE_UNKNOWN;
+
+  for (i = 0; i < count; i++)
+    {
+      if (i % per_pod == 0)
+	{
+	  snprintf (path, sizeof (path), "%s/kubepods/pod%lu", argv[optind],
+		    i / per_pod);
+	  if (make_cgroup (path, now - 86400) < 0)
+	    return STATE_UNKNOWN;
+	}
+      snprintf (path, sizeof (path), "%s/kubepods/pod%lu/container%lu",
+		argv[optind], i / per_pod, i % per_pod);
+      if (make_cgroup (path, now - (time_t)
+		       (((i / per_pod) * 7 + i % per_pod) % 10080) * 60) < 0)
+	return STATE_UNKNOWN;
+    }
+
+  return STATE_OK;
+}
@@ -0,0 +1,97 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Generator of synthetic uptime snapshots for the --fleet benchmark
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Usage: gen_fleet [-n COUNT] [-g GROUPS] FILE
+ *
+ * Writes COUNT records "HOST UPTIME GROUP" (10000000 by default), the
+ * hosts spread over GROUPS groups (16) in runs of 100.  One host in fifty
+ * was rebooted in the last hour, the others have been up for up to a year.
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "nputils.h"
+
+#define GEN_BUFSIZE  (1 << 20)
+
+int
+main (int argc, char **argv)
+{
+  static char buf[GEN_BUFSIZE];
+  unsigned long i, count = 10000000, groups = 16, uptime, seed = 1;
+  size_t len = 0;
+  int c, fd;
+
+  while ((c = getopt (argc, argv, "n:g:")) != -1)
+    switch (c)
+      {
+      case 'n':
+	count = strtoul (optarg, NULL, 10);
+	break;
+      case 'g':
+	groups = strtoul (optarg, NULL, 10);
+	break;
+      default:
+	count = 0;
+	break;
+      }
+
+  if (optind != argc - 1 || count == 0 || groups == 0)
+    {
+      fprintf (stderr, "Usage: %s [-n COUNT] [-g GROUPS] FILE\n", argv[0]);
+      return STATE_UNKNOWN;
+    }
+
+  if ((fd = open (argv[optind], O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+    {
+      perror (argv[optind]);
+      return STATE_UNKNOWN;
+    }
+
+  for (i = 0; i < count; i++)
+    {
+      seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+      uptime = (seed >> 33) % 31536000;
+      if ((seed >> 20) % 50 == 0)
+	uptime %= 3600;
+      len += (size_t) snprintf (buf + len, sizeof (buf) - len,
+				"host%lu.example.com %lu.%02lu group%lu\n",
+				i, uptime, (seed >> 12) % 100,
+				(i / 100) % groups);
+      if (len > sizeof (buf) - 128 || i + 1 == count)
+	{
+	  if (write (fd, buf, len) != (ssize_t) len)
+	    {
+	      perror (argv[optind]);
+	      return STATE_UNKNOWN;
+	    }
+	  len = 0;
+	}
+    }
+
+  return (close (fd) == 0) ? STATE_OK : STATE_UNKNOWN;
+}
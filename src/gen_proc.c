@@ -0,0 +1,103 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Generator of synthetic proc trees for the --process-age benchmark
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Usage: gen_proc [-n COUNT] DIR
+ *
+ * Creates DIR/<pid>/stat for COUNT processes (200000 by default), in the
+ * format of the Linux /proc/<pid>/stat files.  One process in ten is named
+ * "worker", the others "kworker/N", "sshd" and "(sd-pam)".
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "nputils.h"
+
+int
+main (int argc, char **argv)
+{
+  char path[4096], comm[32], stat[512];
+  unsigned long i, count = 200000;
+  int c, fd, len;
+
+  while ((c = getopt (argc, argv, "n:")) != -1)
+    switch (c)
+      {
+      case 'n':
+	count = strtoul (optarg, NULL, 10);
+	break;
+      default:
+	count = 0;
+	break;
+      }
+
+  if (optind != argc - 1 || count == 0)
+    {
+      fprintf (stderr, "Usage: %s [-n COUNT] DIR\n", argv[0]);
+      return STATE_UNKNOWN;
+    }
+  if (mkdir (argv[optind], 0755) < 0 && errno != EEXIST)
+    {
+      perror (argv[optind]);
+      return STATE_UNKNOWN;
+    }
+
+  for (i = 1; i <= count; i++)
+    {
+      if (i % 10 == 0)
+	strcpy (comm, "worker");
+      else if (i % 3 == 0)
+	snprintf (comm, sizeof (comm), "kworker/%lu", i % 64);
+      else
+	strcpy (comm, (i % 3 == 1) ? "sshd" : "(sd-pam)");
+
+      snprintf (path, sizeof (path), "%s/%lu", argv[optind], i);
+      if (mkdir (path, 0755) < 0 && errno != EEXIST)
+	{
+	  perror (path);
+	  return STATE_UNKNOWN;
+	}
+
+      /* the start time (field 22) grows with the pid */
+      len = snprintf (stat, sizeof (stat),
+		      "%lu (%s) S 1 %lu %lu 0 -1 4194560 1520 0 0 0 "
+		      "12 4 0 0 20 0 1 0 %lu 17006592 1403 "
+		      "18446744073709551615 1 1 0 0 0 0 0 4096 81926 0 0 0 "
+		      "17 3 0 0 0 0 0 0 0 0 0 0 0 0 0\n",
+		      i, comm, i, i, 100 + i * 10);
+      snprintf (path, sizeof (path), "%s/%lu/stat", argv[optind], i);
+      if ((fd = open (path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0
+	  || write (fd, stat, len) != len || close (fd) < 0)
+	{
+	  perror (path);
+	  return STATE_UNKNOWN;
+	}
+    }
+
+  return STATE_OK;
+}
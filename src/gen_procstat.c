@@ -0,0 +1,97 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Generator of synthetic /proc/stat files of large machines
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Usage: gen_procstat [-c CPUS] [-i IRQS] FILE
+ *
+ * Writes a /proc/stat with CPUS cpu lines (256 by default), for a machine
+ * up for ten days, and an "intr" line with IRQS counters (8192) as on the
+ * large machines.  Every seventeenth CPU is never idle.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "nputils.h"
+
+#define GEN_UPTIME  864000ULL	/* ten days */
+#define GEN_HZ      100ULL
+
+int
+main (int argc, char **argv)
+{
+  unsigned long cpus = 256, irqs = 8192, i;
+  unsigned long long ticks = GEN_UPTIME * GEN_HZ, idle, busy;
+  FILE *fp;
+  int c;
+
+  while ((c = getopt (argc, argv, "c:i:")) != -1)
+    switch (c)
+      {
+      case 'c':
+	cpus = strtoul (optarg, NULL, 10);
+	break;
+      case 'i':
+	irqs = strtoul (optarg, NULL, 10);
+	break;
+      default:
+	cpus = 0;
+	break;
+      }
+
+  if (optind != argc - 1 || cpus == 0)
+    {
+      fprintf (stderr, "Usage: %s [-c CPUS] [-i IRQS] FILE\n", argv[0]);
+      return STATE_UNKNOWN;
+    }
+
+  if ((fp = fopen (argv[optind], "w")) == NULL)
+    {
+      perror (argv[optind]);
+      return STATE_UNKNOWN;
+    }
+
+  fprintf (fp, "cpu  %llu 0 %llu %llu %llu 0 0 0 0 0\n",
+	   ticks * cpus / 4, ticks * cpus / 8, ticks * cpus / 2,
+	   ticks * cpus / 8);
+  for (i = 0; i < cpus; i++)
+    {
+      idle = (i % 17 == 0) ? 0 : ticks * (20 + i % 80) / 100;
+      busy = ticks - idle;
+      fprintf (fp, "cpu%lu %llu %llu %llu %llu %llu %llu %llu 0 0 0\n", i,
+	       busy * 6 / 10, busy / 100, busy * 3 / 10, idle * 95 / 100,
+	       idle - idle * 95 / 100, busy / 50, busy - busy * 6 / 10
+	       - busy / 100 - busy * 3 / 10 - busy / 50);
+    }
+  fprintf (fp, "intr %llu", ticks * cpus);
+  for (i = 0; i < irqs; i++)
+    fprintf (fp, " %lu", (i % 7 == 0) ? i * 7919 : 0);
+  fprintf (fp, "\nctxt %llu\nbtime 1380000000\nprocesses %llu\n"
+	   "procs_running 3\nprocs_blocked 0\nsoftirq %llu", ticks * 997,
+	   ticks / 3, ticks * 11);
+  for (i = 0; i < 10; i++)
+    fprintf (fp, " %llu", ticks * (i + 1));
+  fputc ('\n', fp);
+
+  return (fclose (fp) == 0) ? STATE_OK : STATE_UNKNOWN;
+}
@@ -0,0 +1,158 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Generator of synthetic wtmp files for the --reboots-since benchmark
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Usage: gen_wtmp [-s SIZE_MB] [-t STEP] [-b HOURS] FILE
+ *
+ * Writes SIZE_MB megabytes (1024 by default) of wtmp records to FILE, one
+ * record every STEP seconds (60) and ending now: logins and logouts, and a
+ * reboot every HOURS hours (24).
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if HAVE_UTMPX_H
+#include <utmpx.h>
+#endif
+
+#include "nputils.h"
+
+#if HAVE_UTMPX_H
+
+#define GEN_BATCH  4096		/* records per write() */
+
+static void
+gen_record (struct utmpx *ut, time_t t, unsigned long i, int boot)
+{
+  memset (ut, 0, sizeof (*ut));
+  ut->ut_tv.tv_sec = t;
+  if (boot)
+    {
+      ut->ut_type = BOOT_TIME;
+      strncpy (ut->ut_user, "reboot", sizeof (ut->ut_user));
+      strncpy (ut->ut_line, "~", sizeof (ut->ut_line));
+      strncpy (ut->ut_id, "~~", sizeof (ut->ut_id));
+      return;
+    }
+
+  ut->ut_type = (i % 2) ? DEAD_PROCESS : USER_PROCESS;
+  ut->ut_pid = 1000 + (pid_t) (i / 2 % 30000);
+  snprintf (ut->ut_line, sizeof (ut->ut_line), "pts/%lu", i / 2 % 64);
+  snprintf (ut->ut_id, sizeof (ut->ut_id), "%lu", i / 2 % 64);
+  if (ut->ut_type == USER_PROCESS)
+    {
+      snprintf (ut->ut_user, sizeof (ut->ut_user), "user%lu", i / 2 % 100);
+      strncpy (ut->ut_host, "10.0.0.1", sizeof (ut->ut_host));
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  struct utmpx *batch;
+  unsigned long i, records, size_mb = 1024, step = 60, boot_hours = 24;
+  time_t t, next_boot;
+  size_t n = 0;
+  int c, fd;
+
+  while ((c = getopt (argc, argv, "s:t:b:")) != -1)
+    switch (c)
+      {
+      case 's':
+	size_mb = strtoul (optarg, NULL, 10);
+	break;
+      case 't':
+	step = strtoul (optarg, NULL, 10);
+	break;
+      case 'b':
+	boot_hours = strtoul (optarg, NULL, 10);
+	break;
+      default:
+	size_mb = 0;
+	break;
+      }
+
+  if (optind != argc - 1 || size_mb == 0 || step == 0 || boot_hours == 0)
+    {
+      fprintf (stderr, "Usage: %s [-s SIZE_MB] [-t STEP] [-b HOURS] FILE\n",
+	       argv[0]);
+      return STATE_UNKNOWN;
+    }
+
+  if ((fd = open (argv[optind], O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+    {
+      perror (argv[optind]);
+      return STATE_UNKNOWN;
+    }
+  if (NULL == (batch = calloc (GEN_BATCH, sizeof (struct utmpx))))
+    {
+      perror ("cannot allocate memory");
+      return STATE_UNKNOWN;
+    }
+
+  records = size_mb * 1024 * 1024 / sizeof (struct utmpx);
+  t = time (NULL) - (time_t) ((records - 1) * step);
+  next_boot = t;
+
+  for (i = 0; i < records; i++, t += step)
+    {
+      gen_record (&batch[n++], t, i, t >= next_boot);
+      if (t >= next_boot)
+	next_boot += boot_hours * 3600;
+
+      if (n == GEN_BATCH || i == records - 1)
+	{
+	  if (write (fd, batch, n * sizeof (struct utmpx)) !=
+	      (ssize_t) (n * sizeof (struct utmpx)))
+	    {
+	      perror (argv[optind]);
+	      return STATE_UNKNOWN;
+	    }
+	  n = 0;
+	}
+    }
+
+  free (batch);
+  if (close (fd) < 0)
+    {
+      perror (argv[optind]);
+      return STATE_UNKNOWN;
+    }
+
+  return STATE_OK;
+}
+
+#else
+
+int
+main (void)
+{
+  fputs ("utmpx.h is not available\n", stderr);
+  return STATE_UNKNOWN;
+}
+
+#endif /* HAVE_UTMPX_H */
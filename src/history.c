@@ -0,0 +1,306 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Uptime history kept in a memory mapped ring buffer and reboot counting
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The history file starts with two copies of the header followed by a ring
+ * of HISTORY_SAMPLES samples.  A run appends its sample to the ring, then
+ * writes the updated header over the older copy with a higher generation
+ * and a checksum: if the process dies in the middle, the next run still
+ * finds the previous header intact.  The runs are serialized by flock().
+ *
+ * A reboot is detected when the system booted after the previous sample.
+ * The header keeps the running count of the reboots and the boot times of
+ * the last HISTORY_BOOTS boots, so counting the boots in a time window
+ * costs at most HISTORY_BOOTS comparisons, whatever the history length.
+ * When all of them are in the window, the older boots are counted from the
+ * running counters of the samples, found by a binary search; if the window
+ * reaches back past the oldest sample kept, the count is a lower bound.
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "history.h"
+#include "nputils.h"
+#include "uptime.h"
+
+#define HISTORY_MAGIC    0x55504849UL	/* "UPHI" */
+#define HISTORY_VERSION  1
+#define HISTORY_SAMPLES  4096
+#define HISTORY_BOOTS    64
+
+struct history_sample
+{
+  int64_t time;
+  int64_t uptime;
+  uint64_t reboots;		/* running reboot counter at 'time' */
+};
+
+struct history_header
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t capacity;		/* number of samples in the ring */
+  uint32_t reserved;
+  uint64_t generation;
+  uint64_t samples;		/* samples ever written */
+  uint64_t reboots;		/* reboots ever seen */
+  uint64_t boots;		/* boot times ever stored */
+  int64_t last_time;
+  int64_t last_uptime;
+  int64_t boot_time[HISTORY_BOOTS];
+  uint32_t pad;
+  uint32_t checksum;		/* FNV-1a of all the previous fields */
+};
+
+struct history_file
+{
+  struct history_header header[2];
+  struct history_sample sample[HISTORY_SAMPLES];
+};
+
+static uint32_t
+history_checksum (const struct history_header *h)
+{
+  const unsigned char *p = (const unsigned char *) h;
+  uint32_t hash = 2166136261U;
+  size_t i;
+
+  for (i = 0; i < offsetof (struct history_header, checksum); i++)
+    hash = (hash ^ p[i]) * 16777619U;
+
+  return hash;
+}
+
+static int
+history_valid (const struct history_header *h)
+{
+  return h->magic == HISTORY_MAGIC && h->version == HISTORY_VERSION
+    && h->capacity == HISTORY_SAMPLES && h->checksum == history_checksum (h);
+}
+
+/* Return the newest valid copy of the header, NULL if there is none */
+static const struct history_header *
+history_current (const struct history_file *hf)
+{
+  const struct history_header *a = &hf->header[0], *b = &hf->header[1];
+
+  if (history_valid (a) && (!history_valid (b)
+			    || a->generation > b->generation))
+    return a;
+  if (history_valid (b))
+    return b;
+
+  return NULL;
+}
+
+/* Number of the stored boots at or after 'since' */
+static unsigned int
+history_boots_since (const struct history_header *h, int64_t since)
+{
+  unsigned int n = 0;
+
+  while (n < h->boots && n < HISTORY_BOOTS
+	 && h->boot_time[(h->boots - 1 - n) % HISTORY_BOOTS] >= since)
+    n++;
+
+  return n;
+}
+
+/*
+ * Number of the boots detected by the samples at or after 'since'.  If
+ * the window starts before the oldest sample kept, '*at_least' is set and
+ * the boots detected by the samples kept are returned
+ */
+static unsigned long
+history_reboots_since (const struct history_file *hf,
+		       const struct history_header *h, int64_t since,
+		       int *at_least)
+{
+  const struct history_sample *s, *prev;
+  uint64_t first, lo, hi, mid;
+  unsigned long n;
+
+  /* the first sample at or after 'since': the last one is at 'now' */
+  first = (h->samples > HISTORY_SAMPLES) ? h->samples - HISTORY_SAMPLES : 0;
+  for (lo = first, hi = h->samples - 1; lo < hi;)
+    {
+      mid = lo + (hi - lo) / 2;
+      if (hf->sample[mid % HISTORY_SAMPLES].time >= since)
+	hi = mid;
+      else
+	lo = mid + 1;
+    }
+
+  s = &hf->sample[lo % HISTORY_SAMPLES];
+  n = (unsigned long) (h->reboots - s->reboots);
+  if (lo == first && first > 0)
+    {
+      *at_least = TRUE;
+      return n;
+    }
+
+  /* the boot detected by this sample may be older than 'since' */
+  prev = (lo > 0) ? &hf->sample[(lo - 1) % HISTORY_SAMPLES] : NULL;
+  if ((prev == NULL || s->reboots != prev->reboots)
+      && s->time - s->uptime >= since)
+    n++;
+
+  return n;
+}
+
+/* Add the sample ('now', 'uptime_secs') to the history 'hf' */
+static const struct history_header *
+history_append (struct history_file *hf, int64_t now, int64_t uptime_secs)
+{
+  const struct history_header *cur = history_current (hf);
+  struct history_header next;
+  struct history_sample *s;
+  int slot;
+
+  if (cur)
+    next = *cur;
+  else
+    {
+      memset (&next, 0, sizeof (next));
+      next.magic = HISTORY_MAGIC;
+      next.version = HISTORY_VERSION;
+      next.capacity = HISTORY_SAMPLES;
+    }
+
+  if (next.samples == 0 || uptime_secs < now - next.last_time)
+    {
+      /* first sample, or the system booted after the previous sample */
+      if (next.samples > 0)
+	next.reboots++;
+      next.boot_time[next.boots++ % HISTORY_BOOTS] = now - uptime_secs;
+    }
+
+  s = &hf->sample[next.samples++ % HISTORY_SAMPLES];
+  s->time = now;
+  s->uptime = uptime_secs;
+  s->reboots = next.reboots;
+
+  next.last_time = now;
+  next.last_uptime = uptime_secs;
+  next.generation++;
+  next.checksum = history_checksum (&next);
+
+  /* overwrite the older copy of the header */
+  slot = (cur == &hf->header[0]) ? 1 : 0;
+  hf->header[slot] = next;
+
+  return &hf->header[slot];
+}
+
+static int
+history_map (const char *path, int *fdp, struct history_file **hfp)
+{
+  struct stat st;
+  void *addr;
+  int fd;
+
+  if ((fd = open (path, O_RDWR | O_CREAT | O_CLOEXEC, 0644)) < 0)
+    return -1;
+  if (flock (fd, LOCK_EX) < 0 || fstat (fd, &st) < 0)
+    goto fail;
+  if (st.st_size == 0
+      && ftruncate (fd, sizeof (struct history_file)) < 0)
+    goto fail;
+  else if (st.st_size != 0 && st.st_size != sizeof (struct history_file))
+    goto fail;
+
+  addr = mmap (NULL, sizeof (struct history_file), PROT_READ | PROT_WRITE,
+	       MAP_SHARED, fd, 0);
+  if (MAP_FAILED == addr)
+    goto fail;
+
+  *fdp = fd;
+  *hfp = addr;
+  return 0;
+
+fail:
+  close (fd);
+  return -1;
+}
+
+/*
+ * Record the current uptime in the history 'path' and check both the
+ * uptime and the number of reboots in the last 'window_hours' hours
+ */
+int
+history_check (const char *path, unsigned int window_hours,
+	       const thresholds * my_threshold,
+	       const thresholds * reboot_threshold)
+{
+  char window[32], result_line[160];
+  const struct history_header *h;
+  struct history_file *hf;
+  time_t uptime_secs, now;
+  unsigned long reboots, older;
+  int64_t since;
+  int fd, status, at_least = FALSE;
+
+  if (UPTIME_RET_FAIL == (uptime_secs = uptime ()))
+    {
+      printf ("UPTIME UNKNOWN: can't get system uptime counter\n");
+      return STATE_UNKNOWN;
+    }
+  now = time (NULL);
+
+  if (history_map (path, &fd, &hf) < 0)
+    {
+      printf ("UPTIME UNKNOWN: cannot open the history file %s\n", path);
+      return STATE_UNKNOWN;
+    }
+
+  h = history_append (hf, now, uptime_secs);
+  since = now - (int64_t) window_hours * 3600;
+  reboots = history_boots_since (h, since);
+  if (reboots == HISTORY_BOOTS && h->boots > HISTORY_BOOTS)
+    {
+      /* the boot times stored do not reach back to the window start */
+      older = history_reboots_since (hf, h, since, &at_least);
+      if (older > reboots)
+	reboots = older;
+    }
+
+  munmap (hf, sizeof (struct history_file));
+  close (fd);
+
+  snprintf (window, sizeof (window), "%u hours", window_hours);
+  status = sprint_reboots_result (result_line, sizeof (result_line),
+				  uptime_secs, (unsigned int) reboots, at_least,
+				  window,
+				  my_threshold, reboot_threshold);
+  printf ("%s\n", result_line);
+
+  return status;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+#include "nputils.h"
+
+int history_check (const char *, unsigned int, const thresholds *,
+		   const thresholds *);
@@ -0,0 +1,426 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Minimal HTTP/1.1 server exporting the uptime metrics to Prometheus
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Only "GET /metrics" and "HEAD /metrics" are served.  The response (for
+ * both the OpenMetrics and the Prometheus text content types) is rendered
+ * at most once per second and sent to every scraper with one writev().
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "httpd.h"
+#include "metrics.h"
+#include "netutils.h"
+#include "nputils.h"
+#include "uptime.h"
+
+#define HTTPD_MAX_CLIENTS   256
+#define HTTPD_REQUEST_SIZE  2048
+#define HTTPD_HEADER_SIZE   256
+
+#define CONTENT_TYPE_OPENMETRICS \
+  "application/openmetrics-text; version=1.0.0; charset=utf-8"
+#define CONTENT_TYPE_PROMETHEUS  "text/plain; version=0.0.4; charset=utf-8"
+
+struct response
+{
+  time_t rendered_at;
+  char body[METRICS_BUFSIZE];
+  size_t body_len;
+  char openmetrics_header[HTTPD_HEADER_SIZE];
+  size_t openmetrics_header_len;
+  char prometheus_header[HTTPD_HEADER_SIZE];
+  size_t prometheus_header_len;
+};
+
+struct client
+{
+  size_t len;
+  char request[HTTPD_REQUEST_SIZE];
+  char *pending;		/* unsent part of the last response */
+  size_t pending_len;
+  int closing;			/* close once 'pending' is sent */
+};
+
+static const char not_found[] =
+  "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+static const char bad_request[] =
+  "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+static volatile sig_atomic_t httpd_quit = FALSE;
+
+static void
+httpd_signal_handler (int sig __attribute__ ((__unused__)))
+{
+  httpd_quit = TRUE;
+}
+
+static size_t
+sprint_header (char *buf, const char *content_type, size_t content_length)
+{
+  return snprintf (buf, HTTPD_HEADER_SIZE,
+		   "HTTP/1.1 200 OK\r\n"
+		   "Content-Type: %s\r\n"
+		   "Content-Length: %lu\r\n\r\n",
+		   content_type, (unsigned long) content_length);
+}
+
+/* Render again the metrics if they are older than one second */
+static void
+refresh_response (struct response *resp, const thresholds * my_threshold)
+{
+  time_t now = time (NULL), uptime_secs;
+
+  if (now == resp->rendered_at)
+    return;
+
+  uptime_secs = uptime ();
+  resp->body_len = sprint_metrics (resp->body, sizeof (resp->body),
+				   uptime_secs, now - uptime_secs,
+				   METRICS_UPTIME, my_threshold);
+  resp->openmetrics_header_len =
+    sprint_header (resp->openmetrics_header, CONTENT_TYPE_OPENMETRICS,
+		   resp->body_len);
+  resp->prometheus_header_len =
+    sprint_header (resp->prometheus_header, CONTENT_TYPE_PROMETHEUS,
+		   resp->body_len);
+  resp->rendered_at = now;
+}
+
+/*
+ * Send the buffers and save the part the socket did not accept.
+ * Returns 0 if okay, otherwise -1
+ */
+static int
+send_response (int fd, struct client *cl, struct iovec *iov, int iovcnt)
+{
+  ssize_t n;
+  size_t total = 0, skip;
+  int i;
+
+  for (i = 0; i < iovcnt; i++)
+    total += iov[i].iov_len;
+
+  if (cl->pending)
+    n = 0;			/* keep the responses in order */
+  else if ((n = writev (fd, iov, iovcnt)) < 0)
+    {
+      if (errno != EAGAIN && errno != EINTR)
+	return -1;
+      n = 0;
+    }
+  if ((size_t) n == total)
+    return 0;
+
+  if (NULL == (cl->pending = realloc (cl->pending,
+				      cl->pending_len + total - n)))
+    return -1;
+  for (i = 0, skip = n; i < iovcnt; i++)
+    {
+      if (skip >= iov[i].iov_len)
+	{
+	  skip -= iov[i].iov_len;
+	  continue;
+	}
+      memcpy (cl->pending + cl->pending_len,
+	      (char *) iov[i].iov_base + skip, iov[i].iov_len - skip);
+      cl->pending_len += iov[i].iov_len - skip;
+      skip = 0;
+    }
+
+  return 0;
+}
+
+static int
+flush_pending (int fd, struct client *cl)
+{
+  ssize_t n;
+
+  if ((n = send (fd, cl->pending, cl->pending_len, MSG_NOSIGNAL)) < 0)
+    return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+
+  cl->pending_len -= n;
+  if (cl->pending_len > 0)
+    memmove (cl->pending, cl->pending + n, cl->pending_len);
+  else
+    {
+      free (cl->pending);
+      cl->pending = NULL;
+    }
+
+  return 0;
+}
+
+/*
+ * Look for the options "close" and "keep-alive" in the Connection headers
+ * among 'headers'.  Returns 1 for close, 0 for keep-alive, or -1 if there
+ * is neither
+ */
+static int
+connection_option (const char *headers)
+{
+  const char *line, *p, *end;
+  size_t len, n;
+  int option = -1;
+
+  for (line = headers; NULL != (line = strchr (line, '\n'));)
+    {
+      if (strncasecmp (++line, "Connection:", 11))
+	continue;
+      end = line + strcspn (line, "\r\n");
+      for (p = line + 11; p < end; p += len + 1)
+	{
+	  p += strspn (p, " \t");
+	  len = strcspn (p, ",\r\n");
+	  for (n = len; n > 0 && (p[n - 1] == ' ' || p[n - 1] == '\t'); n--)
+	    ;
+	  if (n == 5 && !strncasecmp (p, "close", 5))
+	    option = 1;
+	  else if (n == 10 && !strncasecmp (p, "keep-alive", 10) && option < 0)
+	    option = 0;
+	}
+    }
+
+  return option;
+}
+
+/*
+ * Answer one request (request line and headers, without the empty line).
+ * Returns 1 if the connection must be closed after the response, 0 if it
+ * can be kept open, or -1 on error
+ */
+static int
+answer_request (int fd, struct client *cl, char *request,
+		struct response *resp, const thresholds * my_threshold)
+{
+  struct iovec iov[2];
+  char *method, *path, *version, *saveptr = NULL;
+  int head, keep_alive, option;
+
+  method = strtok_r (request, " ", &saveptr);
+  path = strtok_r (NULL, " ", &saveptr);
+  version = strtok_r (NULL, "\r\n", &saveptr);
+  if (NULL == version || strncmp (version, "HTTP/1.", 7))
+    {
+      iov[0].iov_base = (char *) bad_request;
+      iov[0].iov_len = sizeof (bad_request) - 1;
+      return (send_response (fd, cl, iov, 1) < 0) ? -1 : 1;
+    }
+
+  /* HTTP/1.0 closes the connection unless asked otherwise */
+  keep_alive = strcmp (version, "HTTP/1.0") ? TRUE : FALSE;
+  if ((option = connection_option (saveptr)) >= 0)
+    keep_alive = !option;
+
+  head = !strcmp (method, "HEAD");
+  if ((strcmp (method, "GET") && !head) ||
+      (strcmp (path, "/metrics") && strncmp (path, "/metrics?", 9)))
+    {
+      iov[0].iov_base = (char *) not_found;
+      iov[0].iov_len = sizeof (not_found) - 1;
+    }
+  else
+    {
+      refresh_response (resp, my_threshold);
+      if (strstr (saveptr, "application/openmetrics-text"))
+	{
+	  iov[0].iov_base = resp->openmetrics_header;
+	  iov[0].iov_len = resp->openmetrics_header_len;
+	}
+      else
+	{
+	  iov[0].iov_base = resp->prometheus_header;
+	  iov[0].iov_len = resp->prometheus_header_len;
+	}
+      iov[1].iov_base = resp->body;
+      iov[1].iov_len = head ? 0 : resp->body_len;
+    }
+
+  if (send_response (fd, cl, iov, (iov[0].iov_base == not_found) ? 1 : 2)
+      < 0)
+    return -1;
+
+  return keep_alive ? 0 : 1;
+}
+
+/*
+ * Read the data sent by a client and answer every complete request.
+ * Returns 0 if the connection must be kept open, otherwise -1.  After a
+ * response closing the connection the client is marked as closing and
+ * the following requests are ignored
+ */
+static int
+serve_client (int fd, struct client *cl, struct response *resp,
+	      const thresholds * my_threshold)
+{
+  char *request, *end;
+  ssize_t n;
+  int ret;
+
+  n = read (fd, cl->request + cl->len, sizeof (cl->request) - cl->len - 1);
+  if (n < 0)
+    return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+  if (n == 0)
+    return -1;
+
+  cl->len += n;
+  cl->request[cl->len] = '\0';
+
+  request = cl->request;
+  while (NULL != (end = strstr (request, "\r\n\r\n")))
+    {
+      end[2] = '\0';
+      if ((ret = answer_request (fd, cl, request, resp, my_threshold)) < 0)
+	return -1;
+      if (ret > 0)
+	{
+	  cl->closing = TRUE;
+	  cl->len = 0;
+	  return 0;
+	}
+      request = end + 4;
+    }
+
+  cl->len -= request - cl->request;
+  memmove (cl->request, request, cl->len);
+
+  return (cl->len < sizeof (cl->request) - 1) ? 0 : -1;
+}
+
+int
+metrics_server (const char *address, const thresholds * my_threshold)
+{
+  struct pollfd pfd[HTTPD_MAX_CLIENTS + 1];
+  struct client *clients;
+  struct response *resp;
+  struct sigaction sa;
+  int i, j, fd, listen_fd, nfds = 1, status = STATE_OK;
+
+  if ((listen_fd = net_socket_activation ()) < 0 &&
+      (listen_fd = net_listen_tcp (address)) < 0)
+    {
+      perror (address);
+      return STATE_UNKNOWN;
+    }
+
+  clients = calloc (HTTPD_MAX_CLIENTS + 1, sizeof (*clients));
+  resp = calloc (1, sizeof (*resp));
+  if (NULL == clients || NULL == resp)
+    {
+      perror ("cannot allocate memory");
+      status = STATE_UNKNOWN;
+      goto done;
+    }
+
+  memset (&sa, 0, sizeof (sa));
+  sa.sa_handler = httpd_signal_handler;
+  sigaction (SIGINT, &sa, NULL);
+  sigaction (SIGTERM, &sa, NULL);
+  signal (SIGPIPE, SIG_IGN);
+
+  pfd[0].fd = listen_fd;
+  pfd[0].events = POLLIN;
+
+  while (!httpd_quit)
+    {
+      if (poll (pfd, nfds, -1) < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  perror ("poll");
+	  break;
+	}
+
+      for (i = 1; i < nfds; i++)
+	{
+	  int ret = 0;
+
+	  if (clients[i].pending
+	      && (pfd[i].revents & (POLLOUT | POLLHUP | POLLERR)))
+	    ret = flush_pending (pfd[i].fd, &clients[i]);
+	  if (ret == 0 && !clients[i].closing
+	      && (pfd[i].revents & (POLLIN | POLLHUP | POLLERR)))
+	    ret = serve_client (pfd[i].fd, &clients[i], resp, my_threshold);
+	  /* the last response is sent in full before closing */
+	  if (ret == 0 && clients[i].closing && !clients[i].pending)
+	    ret = -1;
+	  if (ret < 0)
+	    {
+	      close (pfd[i].fd);
+	      free (clients[i].pending);
+	      pfd[i].fd = -1;
+	    }
+	  else if (clients[i].closing)
+	    pfd[i].events = POLLOUT;
+	  else
+	    pfd[i].events = clients[i].pending ? POLLIN | POLLOUT : POLLIN;
+	}
+
+      if (pfd[0].revents & POLLIN)
+	while (nfds <= HTTPD_MAX_CLIENTS &&
+	       (fd = accept (listen_fd, NULL, NULL)) >= 0)
+	  {
+	    net_set_nonblock (fd);
+	    pfd[nfds].fd = fd;
+	    pfd[nfds].events = POLLIN;
+	    pfd[nfds].revents = 0;
+	    memset (&clients[nfds], 0, sizeof (struct client));
+	    nfds++;
+	  }
+
+      for (i = j = 1; i < nfds; i++)
+	if (pfd[i].fd >= 0)
+	  {
+	    if (i != j)
+	      {
+		pfd[j] = pfd[i];
+		clients[j] = clients[i];
+	      }
+	    j++;
+	  }
+      nfds = j;
+      pfd[0].events = (nfds <= HTTPD_MAX_CLIENTS) ? POLLIN : 0;
+    }
+
+done:
+  for (i = 1; i < nfds; i++)
+    {
+      close (pfd[i].fd);
+      free (clients[i].pending);
+    }
+  close (listen_fd);
+  free (clients);
+  free (resp);
+
+  return status;
+}
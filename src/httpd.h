@@ -0,0 +1,5 @@
+#pragma once
+
+#include "nputils.h"
+
+int metrics_server (const char *, const thresholds *);
@@ -0,0 +1,68 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Uptime metrics in the Prometheus/OpenMetrics text format
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include "metrics.h"
+#include "nputils.h"
+#include "uptime.h"
+
+/*
+ * Render the metrics for 'uptime_secs' and 'boot_time' in the OpenMetrics
+ * text format, that the Prometheus text parser accepts as well.  The uptime
+ * itself is only rendered when 'flags' has METRICS_UPTIME set.
+ * Returns the length of the text (truncated to 'size' - 1)
+ */
+size_t
+sprint_metrics (char *buf, size_t size, time_t uptime_secs, time_t boot_time,
+		int flags, const thresholds * my_threshold)
+{
+  int status = STATE_UNKNOWN, len = 0;
+
+  if (UPTIME_RET_FAIL != uptime_secs)
+    {
+      status = get_status ((unsigned int) (uptime_secs / 60), my_threshold);
+      if (flags & METRICS_UPTIME)
+	len = snprintf (buf, size,
+			"# HELP node_uptime_seconds System uptime.\n"
+			"# TYPE node_uptime_seconds gauge\n"
+			"# UNIT node_uptime_seconds seconds\n"
+			"node_uptime_seconds %ld\n", (long) uptime_secs);
+      if (len >= 0 && (size_t) len < size)
+	len += snprintf (buf + len, size - len,
+			 "# HELP node_boot_time_seconds System boot time "
+			 "in seconds since the epoch.\n"
+			 "# TYPE node_boot_time_seconds gauge\n"
+			 "# UNIT node_boot_time_seconds seconds\n"
+			 "node_boot_time_seconds %ld\n", (long) boot_time);
+      if (len < 0 || (size_t) len >= size)
+	return (size > 0) ? size - 1 : 0;
+    }
+
+  len += snprintf (buf + len, size - len,
+		   "# HELP check_uptime_state Nagios state of the uptime "
+		   "check (0=OK, 1=WARNING, 2=CRITICAL, 3=UNKNOWN).\n"
+		   "# TYPE check_uptime_state gauge\n"
+		   "check_uptime_state %d\n" "# EOF\n", status);
+
+  return ((size_t) len < size) ? (size_t) len : size - 1;
+}
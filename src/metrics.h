@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stddef.h>
+#include <time.h>
+
+#include "nputils.h"
+
+#define METRICS_BUFSIZE  1024
+
+/* flags of sprint_metrics */
+#define METRICS_UPTIME   0x01
+
+size_t sprint_metrics (char *, size_t, time_t, time_t, int,
+		       const thresholds *);
@@ -0,0 +1,301 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Nagios Event Broker module running the check_uptime checks in-process
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Load it in nagios.cfg with
+ *   broker_module=/usr/local/nagios/lib/nagios-plugins-uptime/uptime_neb.so
+ * optionally followed by the name of the plugin to intercept (default:
+ * check_uptime).  The service checks whose expanded command line runs that
+ * plugin with only --warning and --critical options are executed by the
+ * module when Nagios (4.x) initiates them, and their result is handed to
+ * the core as if the plugin had been forked.  The command line is split
+ * as /bin/sh would do it, quotes and backslashes included; a command line
+ * with a metacharacter or an expansion (an unexpanded $ARGn$ macro, for
+ * instance) is left to the core.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define NSCORE 1
+#include <nagios/nebmodules.h>
+#include <nagios/nebcallbacks.h>
+#include <nagios/nebstructs.h>
+#include <nagios/broker.h>
+#include <nagios/nagios.h>
+
+#include "nputils.h"
+#include "uptime.h"
+
+NEB_API_VERSION (CURRENT_NEB_API_VERSION);
+
+#define NEB_UPTIME_PLUGIN   "check_uptime"
+#define NEB_UPTIME_MAXARGS  16
+
+static void *neb_handle = NULL;
+static char *plugin_name = NULL;
+
+int nebmodule_init (int, char *, nebmodule *);
+int nebmodule_deinit (int, int);
+
+/*
+ * Split 'line' in place into at most 'max' - 1 words, removing the quotes
+ * and the backslashes as /bin/sh does.  Returns the number of words, or -1
+ * if the line needs a shell: a metacharacter, an expansion ("$", a
+ * backquote, a home directory, a glob), an unbalanced quote, or too many
+ * words
+ */
+static int
+split_command_line (char *line, char **argv, int max)
+{
+  const char *p = line;
+  char *out = line, quote = '\0';
+  int argc = 0, in_word = FALSE;
+
+  for (;; p++)
+    {
+      if (quote == '\'')
+	{
+	  if (*p == '\0')
+	    return -1;
+	  if (*p == '\'')
+	    quote = '\0';
+	  else
+	    *out++ = *p;
+	  continue;
+	}
+      if (quote == '"')
+	{
+	  if (*p == '\0' || *p == '$' || *p == '`')
+	    return -1;
+	  if (*p == '"')
+	    quote = '\0';
+	  else if (*p == '\\' && strchr ("\"\\", p[1]) && p[1])
+	    *out++ = *++p;
+	  else
+	    *out++ = *p;
+	  continue;
+	}
+
+      if (*p == '\0')
+	break;
+      if (*p == ' ' || *p == '\t')
+	{
+	  /* 'out' may be 'p': the blank is overwritten once read */
+	  if (in_word)
+	    {
+	      *out++ = '\0';
+	      in_word = FALSE;
+	    }
+	  continue;
+	}
+      if (strchr ("|&;<>()$`*?[]{}#!\n", *p))
+	return -1;
+      /* "~:N" is a range, "~", "~/" or "~user" a home directory */
+      if (*p == '~' && !in_word && p[1] != ':')
+	return -1;
+
+      if (!in_word)
+	{
+	  if (argc == max - 1)
+	    return -1;
+	  argv[argc++] = out;
+	  in_word = TRUE;
+	}
+      if (*p == '\'' || *p == '"')
+	quote = *p;
+      else if (*p == '\\')
+	{
+	  if (*++p == '\0' || *p == '\n')
+	    return -1;
+	  *out++ = *p;
+	}
+      else
+	*out++ = *p;
+    }
+  if (in_word)
+    *out = '\0';
+  argv[argc] = NULL;
+
+  return argc;
+}
+
+/*
+ * Split the command line and look for the plugin thresholds.
+ * Returns 0 if the plugin can be run in-process, otherwise -1
+ */
+static int
+parse_command_line (char *command_line, char **warning, char **critical)
+{
+  char *argv[NEB_UPTIME_MAXARGS], *name;
+  int i, argc;
+
+  if ((argc = split_command_line (command_line, argv,
+				  NEB_UPTIME_MAXARGS)) <= 0)
+    return -1;
+
+  name = strrchr (argv[0], '/');
+  if (strcmp (name ? name + 1 : argv[0], plugin_name))
+    return -1;
+
+  *warning = *critical = NULL;
+  for (i = 1; i < argc; i++)
+    {
+      char **target;
+
+      if (!strcmp (argv[i], "-w") || !strcmp (argv[i], "--warning"))
+	target = warning;
+      else if (!strcmp (argv[i], "-c") || !strcmp (argv[i], "--critical"))
+	target = critical;
+      else if (!strncmp (argv[i], "--warning=", 10))
+	{
+	  *warning = argv[i] + 10;
+	  continue;
+	}
+      else if (!strncmp (argv[i], "--critical=", 11))
+	{
+	  *critical = argv[i] + 11;
+	  continue;
+	}
+      else if (!strncmp (argv[i], "-w", 2))
+	{
+	  *warning = argv[i] + 2;
+	  continue;
+	}
+      else if (!strncmp (argv[i], "-c", 2))
+	{
+	  *critical = argv[i] + 2;
+	  continue;
+	}
+      else
+	return -1;		/* any other option: let the plugin run */
+
+      if (++i == argc)
+	return -1;
+      *target = argv[i];
+    }
+
+  return 0;
+}
+
+/* Run the check and give its result to the Nagios core */
+static void
+submit_check_result (nebstruct_service_check_data * ds, int status,
+		     const char *output)
+{
+  check_result cr;
+
+  init_check_result (&cr);
+  cr.object_check_type = SERVICE_CHECK;
+  cr.host_name = strdup (ds->host_name);
+  cr.service_description = strdup (ds->service_description);
+  cr.check_type = ds->check_type;
+  cr.check_options = CHECK_OPTION_NONE;
+  cr.scheduled_check = TRUE;
+  cr.reschedule_check = TRUE;
+  cr.latency = ds->latency;
+  gettimeofday (&cr.start_time, NULL);
+  cr.finish_time = cr.start_time;
+  cr.early_timeout = FALSE;
+  cr.exited_ok = TRUE;
+  cr.return_code = status;
+  cr.output = strdup (output);
+
+  process_check_result (&cr);
+  free_check_result (&cr);
+}
+
+static int
+service_check_callback (int callback_type, void *data)
+{
+  nebstruct_service_check_data *ds = data;
+  char command_line[MAX_COMMAND_BUFFER], output[128];
+  char *warning, *critical;
+  thresholds my_threshold;
+  time_t uptime_secs;
+  int status;
+
+  if (callback_type != NEBCALLBACK_SERVICE_CHECK_DATA ||
+      ds->type != NEBTYPE_SERVICECHECK_INITIATE || ds->command_line == NULL)
+    return NEB_OK;
+
+  strncpy (command_line, ds->command_line, sizeof (command_line) - 1);
+  command_line[sizeof (command_line) - 1] = '\0';
+  if (parse_command_line (command_line, &warning, &critical) < 0)
+    return NEB_OK;
+
+  /* same output and exit code of main() */
+  if (set_thresholds (&my_threshold, warning, critical) != 0)
+    return NEB_OK;		/* the plugin will print its usage */
+  if (UPTIME_RET_FAIL != (uptime_secs = uptime ()))
+    status = sprint_check_result (output, sizeof (output), uptime_secs,
+				  &my_threshold);
+  else
+    {
+      strcpy (output, "UPTIME UNKNOWN: can't get system uptime counter");
+      status = STATE_UNKNOWN;
+    }
+
+  submit_check_result (ds, status, output);
+
+  return NEBERROR_CALLBACKOVERRIDE;
+}
+
+int
+nebmodule_init (int flags __attribute__ ((__unused__)), char *args,
+		nebmodule * handle)
+{
+  neb_handle = handle;
+  plugin_name = strdup ((args && *args) ? args : NEB_UPTIME_PLUGIN);
+
+  neb_set_module_info (neb_handle, NEBMODULE_MODINFO_TITLE,
+		       (char *) "check_uptime NEB module");
+  neb_set_module_info (neb_handle, NEBMODULE_MODINFO_VERSION,
+		       (char *) PACKAGE_VERSION);
+  neb_set_module_info (neb_handle, NEBMODULE_MODINFO_DESC,
+		       (char *) "Run the check_uptime service checks in-process");
+
+  if (neb_register_callback (NEBCALLBACK_SERVICE_CHECK_DATA, neb_handle, 0,
+			     service_check_callback) != NEB_OK)
+    {
+      logit (NSLOG_RUNTIME_ERROR, TRUE,
+	     "uptime_neb: cannot register the service check callback\n");
+      return NEB_ERROR;
+    }
+
+  logit (NSLOG_INFO_MESSAGE, TRUE,
+	 "uptime_neb: running the %s checks in-process\n", plugin_name);
+
+  return NEB_OK;
+}
+
+int
+nebmodule_deinit (int flags __attribute__ ((__unused__)),
+		  int reason __attribute__ ((__unused__)))
+{
+  neb_deregister_callback (NEBCALLBACK_SERVICE_CHECK_DATA,
+			   service_check_callback);
+  free (plugin_name);
+
+  return NEB_OK;
+}
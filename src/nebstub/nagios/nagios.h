@@ -0,0 +1,103 @@
+#pragma once
+
+/*
+ * The declarations of the Nagios 4 headers used by uptime_neb, with the
+ * same names and values, for the stub harness bench_neb: it plays the
+ * part of the core, so the module can be built and tested without Nagios.
+ * The module itself is built against the real headers.
+ */
+
+#include <stdio.h>
+#include <sys/time.h>
+#include <time.h>
+
+#define CURRENT_NEB_API_VERSION  4
+#define NEB_API_VERSION(x)  int __neb_api_version = x;
+
+#define NEB_OK     0
+#define NEB_ERROR  -1
+
+#define NEBERROR_CALLBACKOVERRIDE  202
+
+#define NEBMODULE_MODINFO_TITLE    0
+#define NEBMODULE_MODINFO_VERSION  3
+#define NEBMODULE_MODINFO_DESC     5
+
+#define NEBCALLBACK_SERVICE_CHECK_DATA  6
+#define NEBTYPE_SERVICECHECK_INITIATE   700
+
+#define NSLOG_RUNTIME_ERROR  1
+#define NSLOG_INFO_MESSAGE   262144
+
+#define MAX_COMMAND_BUFFER  8192
+#define SERVICE_CHECK       1
+#define CHECK_OPTION_NONE   0
+
+typedef struct nebmodule_struct
+{
+  char *filename;
+  char *args;
+  int should_be_loaded;
+  int is_currently_loaded;
+  void *module_handle;
+} nebmodule;
+
+typedef struct nebstruct_service_check_struct
+{
+  int type;
+  int flags;
+  int attr;
+  struct timeval timestamp;
+  char *host_name;
+  char *service_description;
+  int check_type;
+  int current_attempt;
+  int max_attempts;
+  int state;
+  int state_type;
+  int timeout;
+  char *command_name;
+  char *command_args;
+  char *command_line;
+  struct timeval start_time;
+  struct timeval end_time;
+  int early_timeout;
+  double execution_time;
+  double latency;
+  int return_code;
+  char *output;
+  char *long_output;
+  char *perf_data;
+  void *check_result_ptr;
+  void *object_ptr;
+} nebstruct_service_check_data;
+
+typedef struct check_result
+{
+  int object_check_type;
+  char *host_name;
+  char *service_description;
+  int check_type;
+  int check_options;
+  int scheduled_check;
+  int reschedule_check;
+  char *output_file;
+  FILE *output_file_fp;
+  double latency;
+  struct timeval start_time;
+  struct timeval finish_time;
+  int early_timeout;
+  int exited_ok;
+  int return_code;
+  char *output;
+  struct check_result *next;
+} check_result;
+
+int neb_register_callback (int, void *, int, int (*)(int, void *));
+int neb_deregister_callback (int, int (*)(int, void *));
+int neb_set_module_info (void *, int, char *);
+int init_check_result (check_result *);
+int process_check_result (check_result *);
+int free_check_result (check_result *);
+void logit (int, int, const char *, ...)
+  __attribute__ ((__format__ (__printf__, 3, 4)));
@@ -0,0 +1,4 @@
+#pragma once
+
+/* see nagios.h */
+#include "nagios.h"
@@ -0,0 +1,223 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Socket helpers for the resident modes of check_uptime
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "netutils.h"
+
+#define NET_BACKLOG          128
+/* first file descriptor passed by systemd, see sd_listen_fds(3) */
+#define SD_LISTEN_FDS_START  3
+
+int
+net_set_nonblock (int fd)
+{
+  int flags;
+
+  if ((flags = fcntl (fd, F_GETFL)) < 0)
+    return -1;
+  return fcntl (fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static int
+unix_address (struct sockaddr_un *addr, const char *path)
+{
+  if (strlen (path) >= sizeof (addr->sun_path))
+    {
+      errno = ENAMETOOLONG;
+      return -1;
+    }
+
+  memset (addr, 0, sizeof (struct sockaddr_un));
+  addr->sun_family = AF_UNIX;
+  strcpy (addr->sun_path, path);
+
+  return 0;
+}
+
+/*
+ * Remove the socket file 'path' left by a server that is gone.  Returns 0
+ * if 'path' is now free, or -1 (errno EEXIST if it is not a socket,
+ * EADDRINUSE if a server still accepts connections on it)
+ */
+static int
+unlink_stale_socket (const char *path)
+{
+  struct stat st;
+  int fd;
+
+  if (lstat (path, &st) < 0)
+    return (errno == ENOENT) ? 0 : -1;
+  if (!S_ISSOCK (st.st_mode))
+    {
+      errno = EEXIST;
+      return -1;
+    }
+  if ((fd = net_connect_unix (path)) >= 0)
+    {
+      close (fd);
+      errno = EADDRINUSE;
+      return -1;
+    }
+  if (errno != ECONNREFUSED)
+    return -1;
+
+  return unlink (path);
+}
+
+/*
+ * Returns a non-blocking listening socket bound to 'path' (a stale socket
+ * file is removed), or -1 on error
+ */
+int
+net_listen_unix (const char *path)
+{
+  struct sockaddr_un addr;
+  int fd;
+
+  if (unix_address (&addr, path) < 0 || unlink_stale_socket (path) < 0)
+    return -1;
+  if ((fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0)
+    return -1;
+
+  if (bind (fd, (struct sockaddr *) &addr, sizeof (addr)) < 0 ||
+      listen (fd, NET_BACKLOG) < 0 || net_set_nonblock (fd) < 0)
+    {
+      close (fd);
+      return -1;
+    }
+
+  return fd;
+}
+
+/*
+ * Returns a non-blocking listening TCP socket bound to 'address', given as
+ * HOST:PORT, [IPV6]:PORT or PORT (all the local addresses), or -1 on error
+ */
+int
+net_listen_tcp (const char *address)
+{
+  struct addrinfo hints, *res, *ai;
+  char host[NI_MAXHOST];
+  const char *port, *h = NULL;
+  int fd = -1, on = 1;
+  size_t len;
+
+  if (NULL != (port = strrchr (address, ':')))
+    {
+      h = address;
+      len = port - address;
+      if (len > 1 && h[0] == '[' && h[len - 1] == ']')
+	{
+	  h++;
+	  len -= 2;
+	}
+      if (len >= sizeof (host))
+	{
+	  errno = ENAMETOOLONG;
+	  return -1;
+	}
+      memcpy (host, h, len);
+      host[len] = '\0';
+      h = (len > 0) ? host : NULL;
+      port++;
+    }
+  else
+    port = address;
+
+  memset (&hints, 0, sizeof (hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE;
+
+  if (0 != getaddrinfo (h, port, &hints, &res))
+    {
+      errno = EINVAL;
+      return -1;
+    }
+
+  for (ai = res; ai != NULL; ai = ai->ai_next)
+    {
+      if ((fd = socket (ai->ai_family, ai->ai_socktype, ai->ai_protocol)) < 0)
+	continue;
+      setsockopt (fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof (on));
+      if (bind (fd, ai->ai_addr, ai->ai_addrlen) == 0 &&
+	  listen (fd, NET_BACKLOG) == 0 && net_set_nonblock (fd) == 0)
+	break;
+      close (fd);
+      fd = -1;
+    }
+  freeaddrinfo (res);
+
+  return fd;
+}
+
+int
+net_connect_unix (const char *path)
+{
+  struct sockaddr_un addr;
+  int fd;
+
+  if (unix_address (&addr, path) < 0)
+    return -1;
+  if ((fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0)
+    return -1;
+
+  if (connect (fd, (struct sockaddr *) &addr, sizeof (addr)) < 0)
+    {
+      close (fd);
+      return -1;
+    }
+
+  return fd;
+}
+
+/*
+ * Returns the listening socket passed by systemd (socket activation),
+ * or -1 if the process has not been started this way
+ */
+int
+net_socket_activation (void)
+{
+  const char *e;
+
+  if (NULL == (e = getenv ("LISTEN_PID")) || atol (e) != (long) getpid ())
+    return -1;
+  if (NULL == (e = getenv ("LISTEN_FDS")) || atoi (e) < 1)
+    return -1;
+
+  unsetenv ("LISTEN_PID");
+  unsetenv ("LISTEN_FDS");
+
+  if (net_set_nonblock (SD_LISTEN_FDS_START) < 0)
+    return -1;
+
+  return SD_LISTEN_FDS_START;
+}
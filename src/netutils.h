@@ -0,0 +1,7 @@
+#pragma once
+
+int net_set_nonblock (int);
+int net_listen_unix (const char *);
+int net_listen_tcp (const char *);
+int net_connect_unix (const char *);
+int net_socket_activation (void);
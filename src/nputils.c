@@ -20,8 +20,7 @@
 
 #include "config.h"
 
-#include <errno.h>
-#include <stdio.h>
+#include <math.h>
 #include <stdlib.h>
 
 #include <string.h>
@@ -29,107 +28,117 @@
 #include <strings.h>
 #endif
 
-#include "nputils.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
-int check_range (double, range *);
-range *parse_range_string (char *);
-void set_range_start (range *, double);
-void set_range_end (range *, double);
+#include "nputils.h"
+#include "probes.h"
 
 /*
  * Returns TRUE if alert should be raised based on the range 
  */
 int
-check_range (double value, range * my_range)
+check_range (double value, const range * my_range)
 {
-  int no = FALSE;
-  int yes = TRUE;
-
-  if (my_range->alert_on == INSIDE)
-    {
-      no = TRUE;
-      yes = FALSE;
-    }
+  int inside = (my_range->start <= value) & (value <= my_range->end);
 
-  if (my_range->end_infinity == FALSE && my_range->start_infinity == FALSE)
-    {
-      if ((my_range->start <= value) && (value <= my_range->end))
-	return no;
-      else
-	return yes;
-    }
-  else if (my_range->start_infinity == FALSE
-	   && my_range->end_infinity == TRUE)
-    {
-      if (my_range->start <= value)
-	return no;
-      else
-	return yes;
-    }
-  else if (my_range->start_infinity == TRUE
-	   && my_range->end_infinity == FALSE)
-    {
-      if (value <= my_range->end)
-	return no;
-      else
-	return yes;
-    }
-  else
-    return no;
+  return inside ^ (my_range->alert_on == OUTSIDE);
 }
 
 int
-get_status (double value, thresholds * my_thresholds)
+get_status (double value, const thresholds * my_thresholds)
 {
-  if (my_thresholds->critical != NULL)
-    {
-      if (check_range (value, my_thresholds->critical) == TRUE)
-	return STATE_CRITICAL;
-    }
-  if (my_thresholds->warning != NULL)
-    {
-      if (check_range (value, my_thresholds->warning) == TRUE)
-	return STATE_WARNING;
-    }
-  return STATE_OK;
+  int critical = check_range (value, &my_thresholds->critical);
+  int warning = check_range (value, &my_thresholds->warning);
+  int status = (critical * STATE_CRITICAL) | (warning & !critical);
+
+  UPTIME_PROBE2 (status, (long long) value, status);
+
+  return status;
 }
 
+/*
+ * Evaluate 'n' values against the same thresholds.  The loop has no
+ * branches and, when SSE2 is available, checks two values at a time
+ */
 void
-set_range_start (range * this, double value)
+get_status_batch (const double *values, int *status, size_t n,
+		  const thresholds * my_thresholds)
 {
-  this->start = value;
-  this->start_infinity = FALSE;
+  const double cstart = my_thresholds->critical.start;
+  const double cend = my_thresholds->critical.end;
+  const int cout = (my_thresholds->critical.alert_on == OUTSIDE);
+  const double wstart = my_thresholds->warning.start;
+  const double wend = my_thresholds->warning.end;
+  const int wout = (my_thresholds->warning.alert_on == OUTSIDE);
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  const __m128d vcstart = _mm_set1_pd (cstart), vcend = _mm_set1_pd (cend);
+  const __m128d vwstart = _mm_set1_pd (wstart), vwend = _mm_set1_pd (wend);
+  const __m128d vcout = _mm_castsi128_pd (_mm_set1_epi32 (-cout));
+  const __m128d vwout = _mm_castsi128_pd (_mm_set1_epi32 (-wout));
+  const __m128d one = _mm_set1_pd (STATE_WARNING);
+  const __m128d two = _mm_set1_pd (STATE_CRITICAL);
+
+  for (; i + 2 <= n; i += 2)
+    {
+      __m128d v = _mm_loadu_pd (values + i);
+      __m128d critical = _mm_xor_pd (vcout,
+				     _mm_and_pd (_mm_cmple_pd (vcstart, v),
+						 _mm_cmple_pd (v, vcend)));
+      __m128d warning = _mm_xor_pd (vwout,
+				    _mm_and_pd (_mm_cmple_pd (vwstart, v),
+						_mm_cmple_pd (v, vwend)));
+
+      warning = _mm_andnot_pd (critical, warning);
+      _mm_storel_epi64 ((__m128i *) (status + i),
+			_mm_cvttpd_epi32 (_mm_or_pd
+					  (_mm_and_pd (critical, two),
+					   _mm_and_pd (warning, one))));
+    }
+#endif
+
+  for (; i < n; i++)
+    {
+      int critical = ((cstart <= values[i]) & (values[i] <= cend)) ^ cout;
+      int warning = ((wstart <= values[i]) & (values[i] <= wend)) ^ wout;
+
+      status[i] = (critical * STATE_CRITICAL) | (warning & !critical);
+    }
 }
 
-void
-set_range_end (range * this, double value)
+/* A range that never raises an alert */
+static void
+set_range_unset (range * this)
 {
-  this->end = value;
-  this->end_infinity = FALSE;
+  this->start = -HUGE_VAL;
+  this->end = HUGE_VAL;
+  this->alert_on = OUTSIDE;
 }
 
-range *
-parse_range_string (char *str)
+/*
+ * Parse 'str' into 'this'.  Returns 0 if okay, otherwise -1
+ */
+int
+parse_range_string (range * this, const char *str)
 {
-  range *temp_range;
-  double start;
-  double end;
-  char *end_str;
+  const char *end_str;
+  int ret;
 
-  temp_range = (range *) malloc (sizeof (range));
+  UPTIME_PROBE1 (range__entry, str);
 
   /*
    * Set defaults 
    */
-  temp_range->start = 0;
-  temp_range->start_infinity = FALSE;
-  temp_range->end = 0;
-  temp_range->end_infinity = TRUE;
-  temp_range->alert_on = OUTSIDE;
+  this->start = 0;
+  this->end = HUGE_VAL;
+  this->alert_on = OUTSIDE;
 
   if (str[0] == '@')
     {
-      temp_range->alert_on = INSIDE;
+      this->alert_on = INSIDE;
       str++;
     }
 
@@ -137,68 +146,43 @@ parse_range_string (char *str)
   if (end_str != NULL)
     {
       if (str[0] == '~')
-	temp_range->start_infinity = TRUE;
+	this->start = -HUGE_VAL;
       else
-	{
-	  start = strtod (str, NULL);	/* Will stop at the ':' */
-	  set_range_start (temp_range, start);
-	}
+	this->start = strtod (str, NULL);	/* Will stop at the ':' */
       end_str++;		/* Move past the ':' */
     }
   else
     {
       end_str = str;
     }
-  end = strtod (end_str, NULL);
   if (strcmp (end_str, "") != 0)
-    set_range_end (temp_range, end);
+    this->end = strtod (end_str, NULL);
 
-  if (temp_range->start_infinity == TRUE ||
-      temp_range->end_infinity == TRUE ||
-      temp_range->start <= temp_range->end)
-    {
-      return temp_range;
-    }
-  free (temp_range);
-  return NULL;
+  ret = (this->start <= this->end) ? 0 : -1;
+  UPTIME_PROBE1 (range__return, ret);
+
+  return ret;
 }
 
 /*
  * returns 0 if okay, otherwise 1 
  */
 int
-set_thresholds (thresholds ** my_thresholds, char *warn_string,
-		char *critical_string)
+set_thresholds (thresholds * my_thresholds, const char *warn_string,
+		const char *critical_string)
 {
-  thresholds *temp_thresholds = NULL;
-
-  if ((temp_thresholds = malloc (sizeof (thresholds))) == NULL)
-    {
-      printf ("Cannot allocate memory: %s", strerror (errno));
-      exit (STATE_UNKNOWN);
-    }
+  int ret = 0;
 
-  temp_thresholds->warning = NULL;
-  temp_thresholds->critical = NULL;
-
-  if (warn_string != NULL)
-    {
-      if ((temp_thresholds->warning =
-	   parse_range_string (warn_string)) == NULL)
-	{
-	  return NP_RANGE_UNPARSEABLE;
-	}
-    }
-  if (critical_string != NULL)
-    {
-      if ((temp_thresholds->critical =
-	   parse_range_string (critical_string)) == NULL)
-	{
-	  return NP_RANGE_UNPARSEABLE;
-	}
-    }
+  UPTIME_PROBE2 (thresholds__entry, warn_string, critical_string);
+  set_range_unset (&my_thresholds->warning);
+  set_range_unset (&my_thresholds->critical);
 
-  *my_thresholds = temp_thresholds;
+  if ((warn_string != NULL &&
+       parse_range_string (&my_thresholds->warning, warn_string) < 0) ||
+      (critical_string != NULL &&
+       parse_range_string (&my_thresholds->critical, critical_string) < 0))
+    ret = NP_RANGE_UNPARSEABLE;
+  UPTIME_PROBE1 (thresholds__return, ret);
 
-  return 0;
+  return ret;
 }
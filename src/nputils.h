@@ -1,5 +1,9 @@
 #pragma once
 
+#include <stddef.h>
+
+#include "uptimecheck.h"
+
 #define STATE_OK        0
 #define STATE_WARNING   1
 #define STATE_CRITICAL  2
@@ -20,21 +24,17 @@
 #define OUTSIDE 0
 #define INSIDE  1
 
-/* see: nagios-plugins-1.4.15/lib/utils_base.h */
-typedef struct range_struct
-{
-  double start;
-  int start_infinity;		/* FALSE (default) or TRUE */
-  double end;
-  int end_infinity;
-  int alert_on;			/* OUTSIDE (default) or INSIDE */
-} range;
-
-typedef struct thresholds_struct
-{
-  range *warning;
-  range *critical;
-} thresholds;
-
-int get_status (double, thresholds *);
-int set_thresholds (thresholds **, char *, char *);
+/*
+ * see: nagios-plugins-1.4.15/lib/utils_base.h
+ * The ranges are stored as closed intervals, using -HUGE_VAL and HUGE_VAL
+ * for the infinite endpoints; a threshold not set never raises an alert.
+ * The types are shared with the public API of libuptimecheck.
+ */
+typedef uptimecheck_range range;
+typedef uptimecheck_thresholds thresholds;
+
+int check_range (double, const range *);
+int parse_range_string (range *, const char *);
+int get_status (double, const thresholds *);
+void get_status_batch (const double *, int *, size_t, const thresholds *);
+int set_thresholds (thresholds *, const char *, const char *);
@@ -0,0 +1,586 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * NRPE compatible server running the uptime check in-process
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The server accepts the (unencrypted) NRPE version 2 and 3 query packets
+ * for the commands "check_uptime" and "check_uptime!WARNING!CRITICAL"
+ * (the thresholds given to the server are used when the arguments are
+ * empty or omitted) and answers with a packet of the same version.
+ * All the connections are served by one thread through epoll, and closed
+ * NRPE_CONNECTION_TIMEOUT seconds after they were accepted whatever their
+ * state, so idle clients cannot hold the server.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#if HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
+#include "netutils.h"
+#include "nputils.h"
+#include "nrpe.h"
+#include "uptime.h"
+
+#define NRPE_PACKET_VERSION_2   2
+#define NRPE_PACKET_VERSION_3   3
+#define NRPE_QUERY_PACKET       1
+#define NRPE_RESPONSE_PACKET    2
+
+/* v2: version, type, crc32, result code, buffer[1024] and 2 bytes of
+ * structure padding */
+#define NRPE_V2_BUFFER_LENGTH   1024
+#define NRPE_V2_PACKET_SIZE     (10 + NRPE_V2_BUFFER_LENGTH + 2)
+/* v3: version, type, crc32, result code, alignment, buffer length and
+ * buffer; NRPE sends and checksums 'sizeof (v3_packet) - 1 + length'
+ * bytes, that is 3 bytes of structure padding after the buffer */
+#define NRPE_V3_HEADER_SIZE     16
+#define NRPE_V3_PADDING         3
+#define NRPE_V3_MAX_BUFFER      65536
+
+#define NRPE_MAX_EVENTS         64
+#define NRPE_COMMAND            "check_uptime"
+/* the default timeout of check_nrpe: no client waits longer */
+#define NRPE_CONNECTION_TIMEOUT 10
+
+#if HAVE_SYS_EPOLL_H
+
+struct connection
+{
+  int fd;
+  size_t len;			/* bytes read or to be written */
+  size_t pos;			/* bytes already written */
+  int writing;
+  int draining;			/* response sent, reading until EOF */
+  unsigned char *data;
+  size_t size;
+  long long deadline;		/* milliseconds, CLOCK_MONOTONIC */
+  struct connection *prev, *next;
+};
+
+/* the open connections, by deadline */
+struct connections
+{
+  struct connection *first, *last;
+};
+
+static volatile sig_atomic_t nrpe_quit = FALSE;
+static unsigned long crc32_table[256];
+
+static void
+nrpe_signal_handler (int sig __attribute__ ((__unused__)))
+{
+  nrpe_quit = TRUE;
+}
+
+static long long
+msecs (void)
+{
+  struct timespec t;
+
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return (long long) t.tv_sec * 1000LL + t.tv_nsec / 1000000;
+}
+
+static void
+crc32_init (void)
+{
+  unsigned long crc;
+  int i, j;
+
+  for (i = 0; i < 256; i++)
+    {
+      crc = i;
+      for (j = 8; j > 0; j--)
+	crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320UL : crc >> 1;
+      crc32_table[i] = crc;
+    }
+}
+
+static unsigned long
+crc32_update (unsigned long crc, const unsigned char *data, size_t len)
+{
+  while (len--)
+    crc = ((crc >> 8) & 0x00FFFFFFUL) ^ crc32_table[(crc ^ *data++) & 0xFF];
+  return crc;
+}
+
+static unsigned int
+get16 (const unsigned char *p)
+{
+  return ((unsigned int) p[0] << 8) | p[1];
+}
+
+static unsigned long
+get32 (const unsigned char *p)
+{
+  return ((unsigned long) p[0] << 24) | ((unsigned long) p[1] << 16) |
+    ((unsigned long) p[2] << 8) | p[3];
+}
+
+static void
+put16 (unsigned char *p, unsigned int v)
+{
+  p[0] = (v >> 8) & 0xFF;
+  p[1] = v & 0xFF;
+}
+
+static void
+put32 (unsigned char *p, unsigned long v)
+{
+  p[0] = (v >> 24) & 0xFF;
+  p[1] = (v >> 16) & 0xFF;
+  p[2] = (v >> 8) & 0xFF;
+  p[3] = v & 0xFF;
+}
+
+/*
+ * Returns the size of the packet being received, 0 if not yet known,
+ * or -1 if the packet is not a valid NRPE query
+ */
+static long
+packet_size (const unsigned char *data, size_t len)
+{
+  unsigned long buffer_length;
+
+  if (len < NRPE_V3_HEADER_SIZE)
+    return 0;
+  if (get16 (data + 2) != NRPE_QUERY_PACKET)
+    return -1;
+
+  switch (get16 (data))
+    {
+    case NRPE_PACKET_VERSION_2:
+      return NRPE_V2_PACKET_SIZE;
+    case NRPE_PACKET_VERSION_3:
+      buffer_length = get32 (data + 12);
+      if (buffer_length == 0 || buffer_length > NRPE_V3_MAX_BUFFER)
+	return -1;
+      return NRPE_V3_HEADER_SIZE + buffer_length;
+    }
+
+  return -1;
+}
+
+/* Returns TRUE if the checksum of the query is right */
+static int
+check_crc32 (unsigned char *data, size_t len)
+{
+  static const unsigned char padding[NRPE_V3_PADDING];
+  unsigned long packet_crc, crc;
+
+  packet_crc = get32 (data + 4);
+  put32 (data + 4, 0);
+
+  crc = crc32_update (0xFFFFFFFFUL, data, len);
+  if ((crc ^ 0xFFFFFFFFUL) == packet_crc)
+    return TRUE;
+
+  if (get16 (data) == NRPE_PACKET_VERSION_3)
+    {
+      crc = crc32_update (crc, padding, NRPE_V3_PADDING);
+      if ((crc ^ 0xFFFFFFFFUL) == packet_crc)
+	return TRUE;
+    }
+
+  return FALSE;
+}
+
+/*
+ * Run the command sent by the client and write the result in 'output'.
+ * Returns the Nagios state
+ */
+static int
+run_command (char *command, char *output, size_t size, time_t uptime_secs,
+	     char *default_warning, char *default_critical)
+{
+  char *warning = default_warning, *critical = default_critical;
+  char *args;
+  thresholds my_threshold;
+
+  if (!strcmp (command, "_NRPE_CHECK"))
+    {
+      snprintf (output, size, "check_uptime NRPE server, version %s",
+		PACKAGE_VERSION);
+      return STATE_OK;
+    }
+
+  if (NULL != (args = strchr (command, '!')))
+    *args++ = '\0';
+  if (strcmp (command, NRPE_COMMAND))
+    {
+      snprintf (output, size, "NRPE: Command '%.64s' not defined", command);
+      return STATE_UNKNOWN;
+    }
+
+  if (args)
+    {
+      char *sep = strchr (args, '!');
+
+      if (sep)
+	{
+	  *sep++ = '\0';
+	  if (*sep)
+	    critical = sep;
+	}
+      if (*args)
+	warning = args;
+    }
+
+  if (UPTIME_RET_FAIL == uptime_secs)
+    {
+      snprintf (output, size,
+		"UPTIME UNKNOWN: can't get system uptime counter");
+      return STATE_UNKNOWN;
+    }
+  if (set_thresholds (&my_threshold, warning, critical) != 0)
+    {
+      snprintf (output, size, "UPTIME UNKNOWN: invalid thresholds");
+      return STATE_UNKNOWN;
+    }
+
+  return sprint_check_result (output, size, uptime_secs, &my_threshold);
+}
+
+/*
+ * Replace the query received on the connection with the response packet.
+ * Returns 0 if okay, otherwise -1
+ */
+static int
+build_response (struct connection *conn, time_t uptime_secs,
+		char *warning, char *critical)
+{
+  char command[NRPE_V3_MAX_BUFFER + 1], output[NRPE_V2_BUFFER_LENGTH];
+  unsigned int version = get16 (conn->data);
+  size_t command_len, output_len, size;
+  unsigned char *p;
+  unsigned long crc;
+  int status;
+
+  if (!check_crc32 (conn->data, conn->len))
+    return -1;
+
+  if (version == NRPE_PACKET_VERSION_2)
+    {
+      p = conn->data + 10;
+      command_len = NRPE_V2_BUFFER_LENGTH;
+    }
+  else
+    {
+      p = conn->data + NRPE_V3_HEADER_SIZE;
+      command_len = conn->len - NRPE_V3_HEADER_SIZE;
+    }
+  memcpy (command, p, command_len);
+  command[command_len] = '\0';
+
+  status = run_command (command, output, sizeof (output), uptime_secs,
+			warning, critical);
+  output_len = strlen (output);
+
+  size = (version == NRPE_PACKET_VERSION_2) ? NRPE_V2_PACKET_SIZE :
+    NRPE_V3_HEADER_SIZE + output_len + 1 + NRPE_V3_PADDING;
+  if (size > conn->size)
+    {
+      if (NULL == (p = realloc (conn->data, size)))
+	return -1;
+      conn->data = p;
+      conn->size = size;
+    }
+
+  p = conn->data;
+  memset (p, 0, size);
+  put16 (p, version);
+  put16 (p + 2, NRPE_RESPONSE_PACKET);
+  put16 (p + 8, status);
+  if (version == NRPE_PACKET_VERSION_2)
+    memcpy (p + 10, output, output_len);
+  else
+    {
+      put32 (p + 12, output_len + 1);
+      memcpy (p + NRPE_V3_HEADER_SIZE, output, output_len);
+    }
+  crc = crc32_update (0xFFFFFFFFUL, p, size) ^ 0xFFFFFFFFUL;
+  put32 (p + 4, crc);
+
+  conn->len = size;
+  conn->pos = 0;
+  conn->writing = TRUE;
+
+  return 0;
+}
+
+static void
+close_connection (int epfd, struct connections *conns,
+		  struct connection *conn)
+{
+  if (conn->prev)
+    conn->prev->next = conn->next;
+  else
+    conns->first = conn->next;
+  if (conn->next)
+    conn->next->prev = conn->prev;
+  else
+    conns->last = conn->prev;
+
+  epoll_ctl (epfd, EPOLL_CTL_DEL, conn->fd, NULL);
+  close (conn->fd);
+  free (conn->data);
+  free (conn);
+}
+
+/*
+ * Once the response is sent, read what is left of the query (the padding
+ * of the v3 packets) until the client closes: closing a socket with
+ * unread data sends a reset, which can destroy the response.
+ * Returns 0 if the connection must be kept open, otherwise -1
+ */
+static int
+drain_connection (int epfd, struct connection *conn)
+{
+  struct epoll_event ev;
+  ssize_t n;
+
+  if (!conn->draining)
+    {
+      conn->draining = TRUE;
+      shutdown (conn->fd, SHUT_WR);
+      ev.events = EPOLLIN;
+      ev.data.ptr = conn;
+      if (epoll_ctl (epfd, EPOLL_CTL_MOD, conn->fd, &ev) < 0)
+	return -1;
+    }
+
+  while ((n = read (conn->fd, conn->data, conn->size)) > 0)
+    ;
+  return (n < 0 && (errno == EAGAIN || errno == EINTR)) ? 0 : -1;
+}
+
+/*
+ * Serve the I/O event of a connection.
+ * Returns 0 if the connection must be kept open, otherwise -1
+ */
+static int
+serve_connection (int epfd, struct connection *conn, time_t * uptime_secs,
+		  int *have_uptime, char *warning, char *critical)
+{
+  struct epoll_event ev;
+  ssize_t n;
+  long size;
+
+  if (conn->draining)
+    return drain_connection (epfd, conn);
+
+  if (conn->writing)
+    {
+      n = send (conn->fd, conn->data + conn->pos, conn->len - conn->pos,
+		MSG_NOSIGNAL);
+      if (n < 0)
+	return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+      conn->pos += n;
+      /* NRPE answers one query per connection */
+      return (conn->pos < conn->len) ? 0 : drain_connection (epfd, conn);
+    }
+
+  size = packet_size (conn->data, conn->len);
+  if (size > (long) conn->size)
+    {
+      unsigned char *p;
+
+      if (NULL == (p = realloc (conn->data, size)))
+	return -1;
+      conn->data = p;
+      conn->size = size;
+    }
+
+  n = read (conn->fd, conn->data + conn->len,
+	    (size > 0 ? (size_t) size : conn->size) - conn->len);
+  if (n < 0)
+    return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+  if (n == 0)
+    return -1;
+  conn->len += n;
+
+  if (size == 0 && (size = packet_size (conn->data, conn->len)) == 0)
+    return 0;
+  if (size < 0)
+    return -1;
+  if (conn->len < (size_t) size)
+    return 0;
+  /* the trailing padding of the v3 packets is drained after the response */
+  conn->len = size;
+
+  if (!*have_uptime)
+    {
+      *uptime_secs = uptime ();
+      *have_uptime = TRUE;
+    }
+  if (build_response (conn, *uptime_secs, warning, critical) < 0)
+    return -1;
+
+  ev.events = EPOLLOUT;
+  ev.data.ptr = conn;
+  if (epoll_ctl (epfd, EPOLL_CTL_MOD, conn->fd, &ev) < 0)
+    return -1;
+
+  /* most of the time the response fits in the socket buffer */
+  return serve_connection (epfd, conn, uptime_secs, have_uptime,
+			   warning, critical);
+}
+
+static void
+accept_connections (int epfd, int listen_fd, struct connections *conns)
+{
+  struct connection *conn;
+  struct epoll_event ev;
+  int fd;
+
+  while ((fd = accept (listen_fd, NULL, NULL)) >= 0)
+    {
+      net_set_nonblock (fd);
+      if (NULL == (conn = calloc (1, sizeof (*conn))) ||
+	  NULL == (conn->data = malloc (NRPE_V2_PACKET_SIZE)))
+	{
+	  free (conn);
+	  close (fd);
+	  continue;
+	}
+      conn->fd = fd;
+      conn->size = NRPE_V2_PACKET_SIZE;
+      conn->deadline = msecs () + NRPE_CONNECTION_TIMEOUT * 1000LL;
+
+      ev.events = EPOLLIN;
+      ev.data.ptr = conn;
+      if (epoll_ctl (epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+	{
+	  free (conn->data);
+	  free (conn);
+	  close (fd);
+	  continue;
+	}
+
+      /* all the connections have the same timeout: append */
+      conn->prev = conns->last;
+      if (conns->last)
+	conns->last->next = conn;
+      else
+	conns->first = conn;
+      conns->last = conn;
+    }
+}
+
+int
+nrpe_server (const char *address, char *warning, char *critical)
+{
+  struct epoll_event ev, events[NRPE_MAX_EVENTS];
+  struct connections conns = { NULL, NULL };
+  struct connection *conn;
+  struct sigaction sa;
+  int i, n, epfd, listen_fd, have_uptime, timeout;
+  time_t uptime_secs = UPTIME_RET_FAIL;
+  long long now;
+
+  if ((listen_fd = net_socket_activation ()) < 0 &&
+      (listen_fd = net_listen_tcp (address)) < 0)
+    {
+      perror (address);
+      return STATE_UNKNOWN;
+    }
+
+  if ((epfd = epoll_create (NRPE_MAX_EVENTS)) < 0)
+    {
+      perror ("epoll_create");
+      close (listen_fd);
+      return STATE_UNKNOWN;
+    }
+
+  ev.events = EPOLLIN;
+  ev.data.ptr = NULL;
+  epoll_ctl (epfd, EPOLL_CTL_ADD, listen_fd, &ev);
+
+  crc32_init ();
+
+  memset (&sa, 0, sizeof (sa));
+  sa.sa_handler = nrpe_signal_handler;
+  sigaction (SIGINT, &sa, NULL);
+  sigaction (SIGTERM, &sa, NULL);
+  signal (SIGPIPE, SIG_IGN);
+
+  while (!nrpe_quit)
+    {
+      timeout = -1;
+      if (conns.first)
+	{
+	  now = msecs ();
+	  timeout = (conns.first->deadline > now) ?
+	    (int) (conns.first->deadline - now) : 0;
+	}
+      if ((n = epoll_wait (epfd, events, NRPE_MAX_EVENTS, timeout)) < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  perror ("epoll_wait");
+	  break;
+	}
+
+      /* coalesce all the queries of this round into one uptime read */
+      have_uptime = FALSE;
+
+      for (i = 0; i < n; i++)
+	{
+	  if (NULL == (conn = events[i].data.ptr))
+	    accept_connections (epfd, listen_fd, &conns);
+	  else if (serve_connection (epfd, conn, &uptime_secs, &have_uptime,
+				     warning, critical) < 0)
+	    close_connection (epfd, &conns, conn);
+	}
+
+      for (now = msecs (); conns.first && conns.first->deadline <= now;)
+	close_connection (epfd, &conns, conns.first);
+    }
+
+  while (conns.first)
+    close_connection (epfd, &conns, conns.first);
+  close (epfd);
+  close (listen_fd);
+
+  return STATE_OK;
+}
+
+#else
+
+int
+nrpe_server (const char *address __attribute__ ((__unused__)),
+	     char *warning __attribute__ ((__unused__)),
+	     char *critical __attribute__ ((__unused__)))
+{
+  fputs ("the NRPE server requires epoll\n", stderr);
+  return STATE_UNKNOWN;
+}
+
+#endif /* HAVE_SYS_EPOLL_H */
@@ -0,0 +1,3 @@
+#pragma once
+
+int nrpe_server (const char *, char *, char *);
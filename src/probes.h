@@ -0,0 +1,35 @@
+#pragma once
+
+/*
+ * USDT probes of the check path, for SystemTap, bpftrace and perf:
+ *
+ *   uptime__entry ()                      uptime__return (secs)
+ *   source__entry (id, name)              source__return (id, name, secs)
+ *   thresholds__entry (warning, critical) thresholds__return (ret)
+ *   range__entry (str)                    range__return (ret)
+ *   status (value, state)
+ *   format__entry (secs)                  format__return (buf)
+ *
+ * 'id' is the index of the source in uptime_sources[] and 'value' the
+ * checked value truncated to an integer.  Compiled in with configure
+ * --enable-usdt, each probe is a single nop until a tracer attaches to it;
+ * otherwise the macros expand to nothing.
+ */
+
+#if ENABLE_USDT
+#include <sys/sdt.h>
+
+#define UPTIME_PROBE0(name) \
+  DTRACE_PROBE (check_uptime, name)
+#define UPTIME_PROBE1(name, a1) \
+  DTRACE_PROBE1 (check_uptime, name, a1)
+#define UPTIME_PROBE2(name, a1, a2) \
+  DTRACE_PROBE2 (check_uptime, name, a1, a2)
+#define UPTIME_PROBE3(name, a1, a2, a3) \
+  DTRACE_PROBE3 (check_uptime, name, a1, a2, a3)
+#else
+#define UPTIME_PROBE0(name) do { } while (0)
+#define UPTIME_PROBE1(name, a1) do { } while (0)
+#define UPTIME_PROBE2(name, a1, a2) do { } while (0)
+#define UPTIME_PROBE3(name, a1, a2, a3) do { } while (0)
+#endif
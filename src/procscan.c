@@ -0,0 +1,475 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Age of the running processes, read from /proc
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The pids are listed with getdents64() and a large buffer (readdir() on
+ * the platforms without it), then each <pid>/stat file is opened with
+ * openat() relative to the /proc descriptor and read in a buffer reused
+ * for all the processes.  The command name and the start time (field 22,
+ * in clock ticks since the boot) are parsed by hand.  With more than one
+ * thread the pids are split in equal shards.
+ */
+
+#include "config.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#include "nputils.h"
+#include "procscan.h"
+#include "uptime.h"
+
+#define PROCSCAN_DIRBUF   (1024 * 1024)
+
+#if defined(__linux__) && defined(SYS_getdents64)
+struct linux_dirent64
+{
+  unsigned long long d_ino;
+  long long d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[];
+};
+#endif
+
+struct procscan_shard
+{
+  int dirfd;
+  const char *pattern;
+  const unsigned int *pids;
+  size_t npids;
+  int threaded;			/* scanned by another thread */
+  struct procscan_result result;
+};
+
+static int
+is_pid (const char *name, unsigned int *pid)
+{
+  unsigned int n = 0;
+
+  if (*name == '\0')
+    return FALSE;
+  for (; *name; name++)
+    {
+      if (*name < '0' || *name > '9')
+	return FALSE;
+      n = n * 10 + (*name - '0');
+    }
+  *pid = n;
+
+  return TRUE;
+}
+
+static int
+add_pid (unsigned int **pids, size_t *npids, size_t *size, unsigned int pid)
+{
+  unsigned int *p;
+
+  if (*npids == *size)
+    {
+      *size = *size ? *size * 2 : 4096;
+      if (NULL == (p = realloc (*pids, *size * sizeof (unsigned int))))
+	return -1;
+      *pids = p;
+    }
+  (*pids)[(*npids)++] = pid;
+
+  return 0;
+}
+
+/* List the pids found in the directory 'dirfd' */
+static int
+list_pids (int dirfd, unsigned int **pids, size_t *npids)
+{
+#if defined(__linux__) && defined(SYS_getdents64)
+  char *buf;
+  const struct linux_dirent64 *d;
+  long len, pos;
+#else
+  DIR *dir;
+  struct dirent *d;
+  int fd;
+#endif
+  size_t size = 0;
+  unsigned int pid;
+
+  *pids = NULL;
+  *npids = 0;
+
+#if defined(__linux__) && defined(SYS_getdents64)
+  if (NULL == (buf = malloc (PROCSCAN_DIRBUF)))
+    return -1;
+  while ((len = syscall (SYS_getdents64, dirfd, buf, PROCSCAN_DIRBUF)) > 0)
+    for (pos = 0; pos < len; pos += d->d_reclen)
+      {
+	d = (const struct linux_dirent64 *) (buf + pos);
+	if (is_pid (d->d_name, &pid)
+	    && add_pid (pids, npids, &size, pid) < 0)
+	  len = -1;
+      }
+  free (buf);
+
+  return (len < 0) ? -1 : 0;
+#else
+  if ((fd = dup (dirfd)) < 0 || NULL == (dir = fdopendir (fd)))
+    return -1;
+  while (NULL != (d = readdir (dir)))
+    if (is_pid (d->d_name, &pid) && add_pid (pids, npids, &size, pid) < 0)
+      {
+	closedir (dir);
+	return -1;
+      }
+  closedir (dir);
+
+  return 0;
+#endif
+}
+
+/*
+ * Parse the content of a stat file: return the start time in 'start' if
+ * the command name matches 'pattern'.  Returns 0 if it matches
+ */
+static int
+parse_stat (char *buf, const char *pattern, unsigned long long *start)
+{
+  char *comm, *p;
+  int field;
+
+  /* the command name may hold spaces and parentheses */
+  if (NULL == (comm = strchr (buf, '(')) || NULL == (p = strrchr (comm, ')')))
+    return -1;
+  *p = '\0';
+  if (fnmatch (pattern, comm + 1, 0) != 0)
+    return -1;
+
+  /* p + 2 is field 3, the state */
+  for (p += 2, field = 3; field < 22 && *p; p++)
+    if (*p == ' ')
+      field++;
+  if (field != 22 || *p < '0' || *p > '9')
+    return -1;
+
+  for (*start = 0; *p >= '0' && *p <= '9'; p++)
+    *start = *start * 10 + (*p - '0');
+
+  return 0;
+}
+
+/*
+ * Read the stat file of the process 'pid' in the proc directory 'dirfd'
+ * into 'buf' (PROCSCAN_STATBUF bytes).  Returns 0 and its start time in
+ * 'start' if its name matches 'pattern', 1 if it does not match and -1 if
+ * the process has gone
+ */
+int
+procscan_read (int dirfd, unsigned int pid, const char *pattern, char *buf,
+	       unsigned long long *start)
+{
+  char path[32], *p;
+  ssize_t len;
+  int fd;
+
+  /* "<pid>/stat", without snprintf */
+  p = path + sizeof (path);
+  memcpy (p -= sizeof ("/stat"), "/stat", sizeof ("/stat"));
+  do
+    *--p = '0' + pid % 10;
+  while ((pid /= 10) > 0);
+
+  if ((fd = openat (dirfd, p, O_RDONLY | O_CLOEXEC)) < 0)
+    return -1;
+  len = read (fd, buf, PROCSCAN_STATBUF - 1);
+  close (fd);
+  if (len <= 0)
+    return -1;
+  buf[len] = '\0';
+
+  return (parse_stat (buf, pattern, start) < 0) ? 1 : 0;
+}
+
+static void *
+scan_shard (void *arg)
+{
+  struct procscan_shard *shard = arg;
+  struct procscan_result *res = &shard->result;
+  char buf[PROCSCAN_STATBUF];
+  unsigned long long start;
+  size_t i;
+  int ret;
+
+  for (i = 0; i < shard->npids; i++)
+    {
+      if ((ret = procscan_read (shard->dirfd, shard->pids[i], shard->pattern,
+				buf, &start)) < 0)
+	continue;		/* the process has gone */
+      res->scanned++;
+      if (ret > 0)
+	continue;
+
+      if (res->count == 0 || start < res->min_start)
+	res->min_start = start;
+      if (res->count == 0 || start > res->max_start)
+	res->max_start = start;
+      res->count++;
+    }
+
+  return NULL;
+}
+
+/*
+ * Call 'fn' for each process of the proc directory 'dirfd' whose name
+ * matches 'pattern'.  Returns 0 if okay, otherwise -1
+ */
+int
+procscan_foreach (int dirfd, const char *pattern,
+		  void (*fn) (unsigned int, unsigned long long, void *),
+		  void *arg)
+{
+  char buf[PROCSCAN_STATBUF];
+  unsigned long long start;
+  unsigned int *pids;
+  size_t npids, i;
+
+  if (list_pids (dirfd, &pids, &npids) < 0)
+    return -1;
+  for (i = 0; i < npids; i++)
+    if (procscan_read (dirfd, pids[i], pattern, buf, &start) == 0)
+      fn (pids[i], start, arg);
+  free (pids);
+
+  return 0;
+}
+
+/*
+ * Scan the processes in 'proc_root' whose command name matches the
+ * fnmatch() 'pattern' with 'threads' threads.  Returns 0 if okay
+ */
+int
+procscan (const char *proc_root, const char *pattern, unsigned int threads,
+	  struct procscan_result *result)
+{
+  struct procscan_shard shard[PROCSCAN_MAX_THREADS];
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+  pthread_t tid[PROCSCAN_MAX_THREADS];
+#endif
+  unsigned int *pids;
+  size_t npids, i, first, last;
+  int dirfd;
+
+  memset (result, 0, sizeof (*result));
+  if ((dirfd = open (proc_root, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
+    return -1;
+  if (list_pids (dirfd, &pids, &npids) < 0)
+    {
+      close (dirfd);
+      return -1;
+    }
+
+#if !(HAVE_PTHREAD_H && HAVE_PTHREAD)
+  threads = 1;
+#endif
+  if (threads < 1)
+    threads = 1;
+  if (threads > PROCSCAN_MAX_THREADS)
+    threads = PROCSCAN_MAX_THREADS;
+
+  for (i = 0; i < threads; i++)
+    {
+      first = i * npids / threads;
+      last = (i + 1) * npids / threads;
+      memset (&shard[i], 0, sizeof (shard[i]));
+      shard[i].dirfd = dirfd;
+      shard[i].pattern = pattern;
+      shard[i].pids = pids + first;
+      shard[i].npids = last - first;
+    }
+
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+  for (i = 1; i < threads; i++)
+    shard[i].threaded =
+      (pthread_create (&tid[i], NULL, scan_shard, &shard[i]) == 0);
+#endif
+  for (i = 0; i < threads; i++)
+    if (!shard[i].threaded)
+      scan_shard (&shard[i]);
+
+  for (i = 0; i < threads; i++)
+    {
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+      if (shard[i].threaded)
+	pthread_join (tid[i], NULL);
+#endif
+      if (shard[i].result.count > 0)
+	{
+	  if (result->count == 0
+	      || shard[i].result.min_start < result->min_start)
+	    result->min_start = shard[i].result.min_start;
+	  if (result->count == 0
+	      || shard[i].result.max_start > result->max_start)
+	    result->max_start = shard[i].result.max_start;
+	}
+      result->count += shard[i].result.count;
+      result->scanned += shard[i].result.scanned;
+    }
+
+  free (pids);
+  close (dirfd);
+
+  return 0;
+}
+
+/*
+ * Format the result line for the 'count' processes matching 'pattern',
+ * the oldest and the youngest started 'oldest' and 'youngest' seconds
+ * ago, and return the resulting Nagios state.  'min_age_threshold', for
+ * the age in minutes of the youngest, may be NULL.  The pattern is cut
+ * if needed to keep the perfdata whole in 'size' bytes
+ */
+int
+sprint_process_age (char *line, size_t size, const char *pattern,
+		    unsigned long count, time_t oldest, time_t youngest,
+		    const thresholds * my_threshold,
+		    const thresholds * count_threshold,
+		    const thresholds * min_age_threshold)
+{
+  char buf[128], youngest_buf[160], perfdata[96];
+  int status, count_status, min_age_status, len, room;
+
+  count_status = get_status (count, count_threshold);
+  if (count == 0)
+    {
+      status = count_status;
+      snprintf (perfdata, sizeof (perfdata), "|count=0");
+      len = snprintf (NULL, 0, "UPTIME %s: no process matching ''",
+		      status_message (status));
+    }
+  else
+    {
+      status = get_status ((unsigned int) (oldest / 60), my_threshold);
+      if (count_status > status)
+	status = count_status;
+      youngest_buf[0] = '\0';
+      if (min_age_threshold)
+	{
+	  min_age_status = get_status ((unsigned int) (youngest / 60),
+				       min_age_threshold);
+	  if (min_age_status > status)
+	    status = min_age_status;
+	  snprintf (youngest_buf, sizeof (youngest_buf), ", youngest %s",
+		    sprint_uptime (buf, sizeof (buf), youngest));
+	}
+      sprint_uptime (buf, sizeof (buf), oldest);
+      snprintf (perfdata, sizeof (perfdata),
+		"|count=%lu age_max=%u age_min=%u", count,
+		(unsigned int) (oldest / 60), (unsigned int) (youngest / 60));
+      len = snprintf (NULL, 0, "UPTIME %s: %lu process%s '', oldest %s%s",
+		      status_message (status), count,
+		      (count != 1) ? "es" : "", buf, youngest_buf);
+    }
+
+  /* the room left for the pattern */
+  room = (int) size - 1 - len - (int) strlen (perfdata);
+  if (room < 0)
+    room = 0;
+
+  if (count == 0)
+    snprintf (line, size, "UPTIME %s: no process matching '%.*s'%s",
+	      status_message (status), room, pattern, perfdata);
+  else
+    snprintf (line, size, "UPTIME %s: %lu process%s '%.*s', oldest %s%s%s",
+	      status_message (status), count, (count != 1) ? "es" : "",
+	      room, pattern, buf, youngest_buf, perfdata);
+
+  return status;
+}
+
+/* Seconds elapsed since the start time 'start' (in clock ticks) */
+time_t
+procscan_age (unsigned long long start, time_t uptime_secs, long hertz)
+{
+  time_t started = (time_t) (start / hertz);
+
+  return (started < uptime_secs) ? uptime_secs - started : 0;
+}
+
+/*
+ * Check the age in minutes of the oldest process matching 'pattern'
+ * against 'my_threshold', the number of matching processes against
+ * 'count_threshold' and, unless NULL, the age in minutes of the youngest
+ * against 'min_age_threshold'
+ */
+int
+process_age_check (const char *proc_root, const char *pattern,
+		   unsigned int threads, const thresholds * my_threshold,
+		   const thresholds * count_threshold,
+		   const thresholds * min_age_threshold)
+{
+  struct procscan_result res;
+  time_t uptime_secs;
+  size_t size;
+  long hertz;
+  int status;
+  char *line;
+
+  if (UPTIME_RET_FAIL == (uptime_secs = uptime ()))
+    {
+      printf ("UPTIME UNKNOWN: can't get system uptime counter\n");
+      return STATE_UNKNOWN;
+    }
+  if ((hertz = sysconf (_SC_CLK_TCK)) <= 0
+      || procscan (proc_root, pattern, threads, &res) < 0)
+    {
+      printf ("UPTIME UNKNOWN: cannot scan the processes in %s\n",
+	      proc_root);
+      return STATE_UNKNOWN;
+    }
+
+  /* the pattern is given by the user: make room for all of it */
+  size = strlen (pattern) + PROCSCAN_LINE_SIZE;
+  if ((line = malloc (size)) == NULL)
+    {
+      printf ("UPTIME UNKNOWN: out of memory\n");
+      return STATE_UNKNOWN;
+    }
+  status = sprint_process_age (line, size, pattern, res.count,
+			       procscan_age (res.min_start, uptime_secs,
+					     hertz),
+			       procscan_age (res.max_start, uptime_secs,
+					     hertz), my_threshold,
+			       count_threshold, min_age_threshold);
+  printf ("%s\n", line);
+  free (line);
+
+  return status;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stddef.h>
+#include <time.h>
+
+#include "nputils.h"
+
+#define PROC_ROOT  "/proc"
+#define PROCSCAN_MAX_THREADS  64
+#define PROCSCAN_STATBUF  4096
+/* the result line, besides the pattern */
+#define PROCSCAN_LINE_SIZE  256
+
+struct procscan_result
+{
+  unsigned long count;		/* matching processes */
+  unsigned long long min_start;	/* start times, in clock ticks */
+  unsigned long long max_start;
+  unsigned long scanned;	/* processes examined */
+};
+
+int procscan (const char *, const char *, unsigned int,
+	      struct procscan_result *);
+int procscan_read (int, unsigned int, const char *, char *,
+		   unsigned long long *);
+int procscan_foreach (int, const char *,
+		      void (*)(unsigned int, unsigned long long, void *),
+		      void *);
+time_t procscan_age (unsigned long long, time_t, long);
+int sprint_process_age (char *, size_t, const char *, unsigned long, time_t,
+			time_t, const thresholds *, const thresholds *,
+			const thresholds *);
+int process_age_check (const char *, const char *, unsigned int,
+		       const thresholds *, const thresholds *,
+		       const thresholds *);
@@ -0,0 +1,487 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Resident process age tracking fed by the netlink proc connector
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * 'check_uptime --daemon --process-age PATTERN' subscribes to the fork,
+ * exec, comm and exit events of the kernel proc connector and keeps the
+ * processes matching PATTERN in a hash table keyed by pid, also linked in
+ * a list sorted by start time: the oldest and the youngest process are
+ * the ends of the list, so a check costs O(1).  A process started by a
+ * fork inherits the name of its parent, so only the forks of the tracked
+ * processes cost a read of /proc.  The index is rebuilt with a full scan
+ * at startup and when the kernel drops events (ENOBUFS).
+ *
+ * The checks are asked on a Unix socket, served by daemon_serve() with
+ * the protocol of daemon.c, so 'check_uptime --socket PATH' works
+ * unchanged.  Without the proc
+ * connector (it needs CAP_NET_ADMIN) every check scans /proc.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#if HAVE_LINUX_CN_PROC_H
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
+#endif
+
+#include "daemon.h"
+#include "nputils.h"
+#include "procscan.h"
+#include "procwatch.h"
+#include "uptime.h"
+
+#define PROCWATCH_RCVBUF       (4 * 1024 * 1024)
+
+struct pw_node
+{
+  unsigned int pid;
+  unsigned long long start;
+  int prev, next;		/* list sorted by start time */
+  int hnext;			/* hash chain, or free list */
+};
+
+struct pw_index
+{
+  struct pw_node *nodes;
+  int size, free;
+  int *buckets;			/* heads of the hash chains */
+  unsigned int nbuckets;	/* a power of two */
+  int head, tail;		/* oldest and youngest */
+  unsigned long count;
+};
+
+/* the state of the daemon, given to the callbacks of daemon_serve() */
+struct procwatch
+{
+  struct pw_index idx;
+  int nl_fd, dirfd;
+  const char *proc_root, *pattern;
+  char *warning, *critical;
+  const thresholds *count_threshold, *min_age_threshold;
+};
+
+static int *
+pw_bucket (struct pw_index *idx, unsigned int pid)
+{
+  return &idx->buckets[(pid * 2654435761U) & (idx->nbuckets - 1)];
+}
+
+static int
+pw_find (struct pw_index *idx, unsigned int pid)
+{
+  int i;
+
+  for (i = *pw_bucket (idx, pid); i >= 0; i = idx->nodes[i].hnext)
+    if (idx->nodes[i].pid == pid)
+      return i;
+
+  return -1;
+}
+
+static void
+pw_clear (struct pw_index *idx)
+{
+  int i;
+
+  for (i = 0; i < (int) idx->nbuckets; i++)
+    idx->buckets[i] = -1;
+  for (i = 0; i < idx->size; i++)
+    idx->nodes[i].hnext = (i + 1 < idx->size) ? i + 1 : -1;
+  idx->free = (idx->size > 0) ? 0 : -1;
+  idx->head = idx->tail = -1;
+  idx->count = 0;
+}
+
+/* Double the nodes and the buckets.  Returns 0 if okay, otherwise -1 */
+static int
+pw_grow (struct pw_index *idx)
+{
+  struct pw_node *nodes;
+  int *buckets, i, size = idx->size ? idx->size * 2 : 1024;
+
+  if (NULL == (nodes = realloc (idx->nodes, size * sizeof (*nodes))))
+    return -1;
+  idx->nodes = nodes;
+  if (NULL == (buckets = realloc (idx->buckets, size * sizeof (int))))
+    return -1;
+  idx->buckets = buckets;
+  idx->nbuckets = size;
+
+  /* rehash the nodes in use */
+  for (i = 0; i < size; i++)
+    buckets[i] = -1;
+  for (i = idx->head; i >= 0; i = nodes[i].next)
+    {
+      nodes[i].hnext = *pw_bucket (idx, nodes[i].pid);
+      *pw_bucket (idx, nodes[i].pid) = i;
+    }
+  for (i = idx->size; i < size; i++)
+    nodes[i].hnext = (i + 1 < size) ? i + 1 : idx->free;
+  idx->free = idx->size;
+  idx->size = size;
+
+  return 0;
+}
+
+static void
+pw_remove (struct pw_index *idx, unsigned int pid)
+{
+  struct pw_node *n;
+  int *link, i;
+
+  for (link = pw_bucket (idx, pid); (i = *link) >= 0;
+       link = &idx->nodes[i].hnext)
+    if (idx->nodes[i].pid == pid)
+      break;
+  if (i < 0)
+    return;
+
+  n = &idx->nodes[i];
+  *link = n->hnext;
+  if (n->prev >= 0)
+    idx->nodes[n->prev].next = n->next;
+  else
+    idx->head = n->next;
+  if (n->next >= 0)
+    idx->nodes[n->next].prev = n->prev;
+  else
+    idx->tail = n->prev;
+
+  n->hnext = idx->free;
+  idx->free = i;
+  idx->count--;
+}
+
+/*
+ * Add or update the process 'pid'.  The new processes are the youngest,
+ * so the insertion point is found walking back from the tail.
+ */
+static int
+pw_insert (struct pw_index *idx, unsigned int pid, unsigned long long start)
+{
+  struct pw_node *n;
+  int i, after;
+
+  if ((i = pw_find (idx, pid)) >= 0)
+    {
+      if (idx->nodes[i].start == start)
+	return 0;
+      pw_remove (idx, pid);	/* pid reused */
+    }
+  if (idx->free < 0 && pw_grow (idx) < 0)
+    return -1;
+
+  i = idx->free;
+  n = &idx->nodes[i];
+  idx->free = n->hnext;
+  n->pid = pid;
+  n->start = start;
+  n->hnext = *pw_bucket (idx, pid);
+  *pw_bucket (idx, pid) = i;
+
+  for (after = idx->tail; after >= 0 && idx->nodes[after].start > start;
+       after = idx->nodes[after].prev)
+    ;
+  n->prev = after;
+  n->next = (after >= 0) ? idx->nodes[after].next : idx->head;
+  if (n->next >= 0)
+    idx->nodes[n->next].prev = i;
+  else
+    idx->tail = i;
+  if (after >= 0)
+    idx->nodes[after].next = i;
+  else
+    idx->head = i;
+  idx->count++;
+
+  return 0;
+}
+
+static void
+pw_scan_callback (unsigned int pid, unsigned long long start, void *arg)
+{
+  pw_insert (arg, pid, start);
+}
+
+/* Rebuild the index with a full scan of the proc directory 'dirfd' */
+static int
+pw_resync (struct pw_index *idx, int dirfd, const char *pattern)
+{
+  pw_clear (idx);
+  return procscan_foreach (dirfd, pattern, pw_scan_callback, idx);
+}
+
+#if HAVE_LINUX_CN_PROC_H
+
+/* Subscribe to the proc connector.  Returns the socket, or -1 */
+static int
+pw_netlink_open (void)
+{
+  struct sockaddr_nl sa;
+  union
+  {
+    struct nlmsghdr nl;
+    char buf[NLMSG_SPACE (sizeof (struct cn_msg)
+			  + sizeof (enum proc_cn_mcast_op))];
+  } msg;
+  struct cn_msg *cn;
+  enum proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+  int fd, rcvbuf = PROCWATCH_RCVBUF;
+
+  if ((fd = socket (PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+		    NETLINK_CONNECTOR)) < 0)
+    return -1;
+  setsockopt (fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof (rcvbuf));
+
+  memset (&sa, 0, sizeof (sa));
+  sa.nl_family = AF_NETLINK;
+  sa.nl_groups = CN_IDX_PROC;
+  sa.nl_pid = getpid ();
+  if (bind (fd, (struct sockaddr *) &sa, sizeof (sa)) < 0)
+    goto fail;
+
+  memset (&msg, 0, sizeof (msg));
+  msg.nl.nlmsg_len = sizeof (msg.buf);
+  msg.nl.nlmsg_type = NLMSG_DONE;
+  msg.nl.nlmsg_pid = getpid ();
+  cn = NLMSG_DATA (&msg.nl);
+  cn->id.idx = CN_IDX_PROC;
+  cn->id.val = CN_VAL_PROC;
+  cn->len = sizeof (op);
+  memcpy (cn->data, &op, sizeof (op));
+  if (send (fd, &msg, sizeof (msg.buf), 0) < 0)
+    goto fail;
+
+  return fd;
+
+fail:
+  close (fd);
+  return -1;
+}
+
+/* Re-read the process 'pid' and add it if its name matches */
+static void
+pw_update (struct pw_index *idx, int dirfd, const char *pattern,
+	   unsigned int pid)
+{
+  char buf[PROCSCAN_STATBUF];
+  unsigned long long start;
+
+  if (procscan_read (dirfd, pid, pattern, buf, &start) == 0)
+    pw_insert (idx, pid, start);
+  else
+    pw_remove (idx, pid);
+}
+
+static void
+pw_event (struct pw_index *idx, int dirfd, const char *pattern,
+	  const struct proc_event *ev)
+{
+  switch (ev->what)
+    {
+    case PROC_EVENT_FORK:
+      /* only the new processes of a tracked parent can match */
+      if (ev->event_data.fork.child_pid == ev->event_data.fork.child_tgid
+	  && pw_find (idx, ev->event_data.fork.parent_tgid) >= 0)
+	pw_update (idx, dirfd, pattern, ev->event_data.fork.child_tgid);
+      break;
+    case PROC_EVENT_EXEC:
+      pw_update (idx, dirfd, pattern, ev->event_data.exec.process_tgid);
+      break;
+    case PROC_EVENT_COMM:
+      if (ev->event_data.comm.process_pid == ev->event_data.comm.process_tgid)
+	pw_update (idx, dirfd, pattern, ev->event_data.comm.process_tgid);
+      break;
+    case PROC_EVENT_EXIT:
+      if (ev->event_data.exit.process_pid == ev->event_data.exit.process_tgid)
+	pw_remove (idx, ev->event_data.exit.process_tgid);
+      break;
+    default:
+      break;
+    }
+}
+
+/*
+ * Apply the pending events.  Returns -1 if the kernel dropped some and
+ * the index must be rebuilt
+ */
+static int
+pw_netlink_read (int fd, struct pw_index *idx, int dirfd,
+		 const char *pattern)
+{
+  char buf[16384] __attribute__ ((aligned (NLMSG_ALIGNTO)));
+  const struct nlmsghdr *nl;
+  const struct cn_msg *cn;
+  ssize_t len;
+
+  while ((len = recv (fd, buf, sizeof (buf), 0)) != 0)
+    {
+      if (len < 0)
+	return (errno == ENOBUFS) ? -1 : 0;
+
+      for (nl = (const struct nlmsghdr *) buf; NLMSG_OK (nl, len);
+	   nl = NLMSG_NEXT (nl, len))
+	{
+	  if (nl->nlmsg_type == NLMSG_ERROR || nl->nlmsg_type == NLMSG_NOOP)
+	    continue;
+	  cn = NLMSG_DATA (nl);
+	  if (cn->id.idx == CN_IDX_PROC && cn->id.val == CN_VAL_PROC)
+	    pw_event (idx, dirfd, pattern,
+		      (const struct proc_event *) cn->data);
+	}
+    }
+
+  return 0;
+}
+
+#else
+
+static int
+pw_netlink_open (void)
+{
+  errno = ENOSYS;
+  return -1;
+}
+
+static int
+pw_netlink_read (int fd __attribute__ ((__unused__)),
+		 struct pw_index *idx __attribute__ ((__unused__)),
+		 int dirfd __attribute__ ((__unused__)),
+		 const char *pattern __attribute__ ((__unused__)))
+{
+  return 0;
+}
+
+#endif /* HAVE_LINUX_CN_PROC_H */
+
+/* apply the events of the proc connector before the requests */
+static void
+pw_round (int ready, void *arg)
+{
+  struct procwatch *pw = arg;
+
+  if (ready && pw_netlink_read (pw->nl_fd, &pw->idx, pw->dirfd,
+				pw->pattern) < 0)
+    pw_resync (&pw->idx, pw->dirfd, pw->pattern);
+}
+
+static void
+pw_answer (char *request, char *reply, size_t size, void *arg)
+{
+  struct procwatch *pw = arg;
+  const struct pw_index *idx = &pw->idx;
+  char *warning = pw->warning, *critical = pw->critical;
+  struct procscan_result res;
+  thresholds my_threshold;
+  time_t uptime_secs;
+  long hertz = sysconf (_SC_CLK_TCK);
+
+  if (daemon_parse_request (request, &warning, &critical) < 0 ||
+      set_thresholds (&my_threshold, warning, critical) != 0)
+    snprintf (reply, size, "UPTIME UNKNOWN: invalid request");
+  else if (UPTIME_RET_FAIL == (uptime_secs = uptime ()) || hertz <= 0)
+    snprintf (reply, size, "UPTIME UNKNOWN: can't get system uptime counter");
+  else if (pw->nl_fd >= 0)
+    sprint_process_age (reply, size, pw->pattern, idx->count,
+			(idx->count > 0) ?
+			procscan_age (idx->nodes[idx->head].start,
+				      uptime_secs, hertz) : 0,
+			(idx->count > 0) ?
+			procscan_age (idx->nodes[idx->tail].start,
+				      uptime_secs, hertz) : 0,
+			&my_threshold, pw->count_threshold,
+			pw->min_age_threshold);
+  else if (procscan (pw->proc_root, pw->pattern, 1, &res) < 0)
+    snprintf (reply, size, "UPTIME UNKNOWN: cannot scan the processes in %s",
+	      pw->proc_root);
+  else
+    sprint_process_age (reply, size, pw->pattern, res.count,
+			procscan_age (res.min_start, uptime_secs, hertz),
+			procscan_age (res.max_start, uptime_secs, hertz),
+			&my_threshold, pw->count_threshold,
+			pw->min_age_threshold);
+}
+
+int
+procwatch_daemon (const char *socket_path, const char *proc_root,
+		  const char *pattern, char *warning, char *critical,
+		  const thresholds * count_threshold,
+		  const thresholds * min_age_threshold)
+{
+  struct procwatch pw;
+  struct daemon_handler handler;
+  int listen_fd, status;
+
+  memset (&pw, 0, sizeof (pw));
+  pw.proc_root = proc_root;
+  pw.pattern = pattern;
+  pw.warning = warning;
+  pw.critical = critical;
+  pw.count_threshold = count_threshold;
+  pw.min_age_threshold = min_age_threshold;
+  pw.idx.head = pw.idx.tail = pw.idx.free = -1;
+
+  if ((pw.dirfd = open (proc_root, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
+    {
+      perror (proc_root);
+      return STATE_UNKNOWN;
+    }
+  if (pw_grow (&pw.idx) < 0)
+    {
+      perror ("cannot allocate memory");
+      return STATE_UNKNOWN;
+    }
+
+  /* subscribe before the scan, so that no process is missed */
+  if ((pw.nl_fd = pw_netlink_open ()) < 0)
+    fprintf (stderr, "proc connector not available (%s), scanning %s "
+	     "at each check\n", strerror (errno), proc_root);
+  else if (pw_resync (&pw.idx, pw.dirfd, pattern) < 0)
+    {
+      perror (proc_root);
+      return STATE_UNKNOWN;
+    }
+
+  if ((listen_fd = daemon_listen (&socket_path)) < 0)
+    return STATE_UNKNOWN;
+
+  handler.fd = pw.nl_fd;
+  handler.round = pw_round;
+  handler.answer = pw_answer;
+  handler.arg = &pw;
+  status = daemon_serve (listen_fd, socket_path, &handler);
+
+  if (pw.nl_fd >= 0)
+    close (pw.nl_fd);
+  close (pw.dirfd);
+  free (pw.idx.nodes);
+  free (pw.idx.buckets);
+
+  return status;
+}
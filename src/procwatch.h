@@ -0,0 +1,6 @@
+#pragma once
+
+#include "nputils.h"
+
+int procwatch_daemon (const char *, const char *, const char *, char *,
+		      char *, const thresholds *, const thresholds *);
@@ -0,0 +1,197 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Publication of the uptime and check state in POSIX shared memory
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nputils.h"
+#include "shmstate.h"
+#include "uptime.h"
+
+#if HAVE_SHM_OPEN
+
+#include "uptime_shm.h"
+
+static volatile sig_atomic_t shm_quit = FALSE;
+
+static void
+shm_signal_handler (int sig __attribute__ ((__unused__)))
+{
+  shm_quit = TRUE;
+}
+
+/* Publish 'snap' in the segment 'shm', the only writer */
+void
+shm_write (struct uptime_shm *shm, const struct uptime_shm_snapshot *snap)
+{
+  int64_t *dst = (int64_t *) & shm->snap;
+  union
+  {
+    struct uptime_shm_snapshot snap;
+    int64_t words[UPTIME_SHM_FIELDS];
+  } copy;
+  uint32_t seq = shm->seq;
+  unsigned int i;
+
+  copy.snap = *snap;
+  __atomic_store_n (&shm->seq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence (__ATOMIC_RELEASE);
+  for (i = 0; i < UPTIME_SHM_FIELDS; i++)
+    __atomic_store_n (&dst[i], copy.words[i], __ATOMIC_RELAXED);
+  __atomic_store_n (&shm->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+int
+shm_publisher (const char *name, unsigned int interval,
+	       const thresholds * my_threshold)
+{
+  struct uptime_shm *shm;
+  struct uptime_shm_snapshot snap;
+  struct sigaction sa;
+  time_t uptime_secs, now;
+  int fd, status;
+
+  if ((fd = shm_open (name, O_CREAT | O_RDWR, 0644)) < 0 ||
+      ftruncate (fd, sizeof (struct uptime_shm)) < 0)
+    {
+      perror (name);
+      return STATE_UNKNOWN;
+    }
+  shm = mmap (NULL, sizeof (struct uptime_shm), PROT_READ | PROT_WRITE,
+	      MAP_SHARED, fd, 0);
+  close (fd);
+  if (MAP_FAILED == shm)
+    {
+      perror ("mmap");
+      return STATE_UNKNOWN;
+    }
+
+  /* keep the readers away until the first snapshot is published */
+  memset (shm, 0, sizeof (struct uptime_shm));
+  memset (&snap, 0, sizeof (snap));
+  snap.state = -1;
+  snap.interval = (interval > 0) ? interval : 1;
+  shm->version = UPTIME_SHM_VERSION;
+  __atomic_store_n (&shm->magic, UPTIME_SHM_MAGIC, __ATOMIC_RELEASE);
+
+  memset (&sa, 0, sizeof (sa));
+  sa.sa_handler = shm_signal_handler;
+  sigaction (SIGINT, &sa, NULL);
+  sigaction (SIGTERM, &sa, NULL);
+
+  while (!shm_quit)
+    {
+      now = time (NULL);
+      if (UPTIME_RET_FAIL != (uptime_secs = uptime ()))
+	{
+	  status = get_status ((unsigned int) (uptime_secs / 60),
+			       my_threshold);
+	  snap.boot_time = now - uptime_secs;
+	  snap.uptime = uptime_secs;
+	}
+      else
+	status = STATE_UNKNOWN;
+
+      if (status != snap.state)
+	{
+	  snap.state_changed_at = now;
+	  if (status == STATE_WARNING)
+	    snap.warning_at = now;
+	  else if (status == STATE_CRITICAL)
+	    snap.critical_at = now;
+	  snap.state = status;
+	}
+      snap.updated_at = now;
+
+      shm_write (shm, &snap);
+      sleep (snap.interval);
+    }
+
+  munmap (shm, sizeof (struct uptime_shm));
+  shm_unlink (name);
+
+  return STATE_OK;
+}
+
+/*
+ * Check the uptime published in the shared memory segment 'name' against
+ * the thresholds, as if it was read locally.  The check is UNKNOWN when
+ * the publisher stopped updating the segment
+ */
+int
+shm_check (const char *name, const thresholds * my_threshold)
+{
+  char result_line[128];
+  const struct uptime_shm *shm;
+  struct uptime_shm_snapshot snap;
+  time_t now;
+  int status;
+
+  if (NULL == (shm = uptime_shm_open (name)))
+    {
+      printf ("UPTIME UNKNOWN: cannot map the shared memory %s\n", name);
+      return STATE_UNKNOWN;
+    }
+  if (uptime_shm_read (shm, &snap) < 0 || snap.boot_time == 0)
+    {
+      printf ("UPTIME UNKNOWN: no consistent uptime published in %s\n",
+	      name);
+      return STATE_UNKNOWN;
+    }
+  now = time (NULL);
+  if (uptime_shm_stale (&snap, now))
+    {
+      printf ("UPTIME UNKNOWN: the uptime published in %s is %ld seconds "
+	      "old\n", name, (long) (now - snap.updated_at));
+      return STATE_UNKNOWN;
+    }
+
+  status = sprint_check_result (result_line, sizeof (result_line),
+				now - snap.boot_time, my_threshold);
+  printf ("%s\n", result_line);
+
+  return status;
+}
+
+#else
+
+int
+shm_publisher (const char *name __attribute__ ((__unused__)),
+	       unsigned int interval __attribute__ ((__unused__)),
+	       const thresholds * my_threshold __attribute__ ((__unused__)))
+{
+  fputs ("POSIX shared memory is not supported\n", stderr);
+  return STATE_UNKNOWN;
+}
+
+int
+shm_check (const char *name __attribute__ ((__unused__)),
+	   const thresholds * my_threshold __attribute__ ((__unused__)))
+{
+  printf ("UPTIME UNKNOWN: POSIX shared memory is not supported\n");
+  return STATE_UNKNOWN;
+}
+
+#endif /* HAVE_SHM_OPEN */
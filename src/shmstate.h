@@ -0,0 +1,12 @@
+#pragma once
+
+#include "nputils.h"
+
+#if HAVE_SHM_OPEN
+#include "uptime_shm.h"
+
+void shm_write (struct uptime_shm *, const struct uptime_shm_snapshot *);
+#endif
+
+int shm_publisher (const char *, unsigned int, const thresholds *);
+int shm_check (const char *, const thresholds *);
@@ -0,0 +1,94 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Benchmark of the uptime sources available on the running host
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#include "nputils.h"
+#include "sources.h"
+#include "uptime.h"
+
+/* how long each source is called for */
+#define BENCH_NSECS  100000000LL
+#define BENCH_BATCH  256
+
+static long long
+nsecs (void)
+{
+  struct timespec t;
+
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return (long long) t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+/*
+ * Print the cost per call of every uptime source and how many seconds
+ * its value differs from the one of the default source.
+ */
+int
+benchmark_sources (void)
+{
+  const struct uptime_source *src;
+  volatile time_t sink;
+  time_t reference, value;
+  long long start, elapsed;
+  long calls;
+  int i;
+
+  if (UPTIME_RET_FAIL == (reference = uptime ()))
+    {
+      printf ("UPTIME UNKNOWN: can't get system uptime counter\n");
+      return STATE_UNKNOWN;
+    }
+
+  printf ("%-10s %12s %12s %8s  %s\n",
+	  "source", "ns/call", "uptime", "delta", "description");
+
+  for (src = uptime_sources; src->name; src++)
+    {
+      if (UPTIME_RET_FAIL == (value = src->get ()))
+	{
+	  printf ("%-10s %12s %12s %8s  %s\n", src->name,
+		  "-", "-", "-", "unavailable");
+	  continue;
+	}
+
+      calls = 0;
+      start = nsecs ();
+      do
+	{
+	  for (i = 0; i < BENCH_BATCH; i++)
+	    sink = src->get ();
+	  calls += BENCH_BATCH;
+	}
+      while ((elapsed = nsecs () - start) < BENCH_NSECS);
+      (void) sink;
+
+      reference = uptime ();
+      value = src->get ();
+      printf ("%-10s %12.1f %12ld %+8ld  %s\n", src->name,
+	      (double) elapsed / calls, (long) value,
+	      (long) (value - reference), src->description);
+    }
+
+  return STATE_OK;
+}
@@ -0,0 +1,231 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Check of all the sysinfo() metrics with a single system call
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * sysinfo() returns, besides the uptime, the load averages, the memory and
+ * swap sizes and the number of tasks: all of them are checked, each
+ * against its own --metric-warning NAME=RANGE and --metric-critical
+ * NAME=RANGE, and reported in the perfdata, so a single exec replaces
+ * check_load and check_swap.  The uptime, in minutes, is checked against
+ * --warning and --critical as well.
+ *
+ * info.procs counts the tasks, every thread included, not the processes.
+ * The page cache is not reported, so the used memory cannot be computed:
+ * only the free one is.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if HAVE_SYS_SYSINFO_H
+#include <sys/sysinfo.h>
+#endif
+
+#include "nputils.h"
+#include "sysmetrics.h"
+#include "uptime.h"
+
+enum
+{
+  SM_UPTIME,
+  SM_LOAD1,
+  SM_LOAD5,
+  SM_LOAD15,
+  SM_TASKS,
+  SM_RAM_TOTAL,
+  SM_RAM_FREE,
+  SM_RAM_SHARED,
+  SM_RAM_BUFFER,
+  SM_RAM_FREE_PCT,
+  SM_SWAP_TOTAL,
+  SM_SWAP_FREE,
+  SM_SWAP_USED_PCT,
+  SM_HIGH_TOTAL,
+  SM_HIGH_FREE,
+  SM_METRICS
+};
+
+static const struct
+{
+  const char *name;
+  const char *uom;		/* unit of measurement of the perfdata */
+  int decimals;
+} sm_metrics[SM_METRICS] = {
+  {"uptime", "", 0},
+  {"load1", "", 2},
+  {"load5", "", 2},
+  {"load15", "", 2},
+  {"tasks", "", 0},
+  {"ram_total", "B", 0},
+  {"ram_free", "B", 0},
+  {"ram_shared", "B", 0},
+  {"ram_buffer", "B", 0},
+  {"ram_free_pct", "%", 2},
+  {"swap_total", "B", 0},
+  {"swap_free", "B", 0},
+  {"swap_used_pct", "%", 2},
+  {"high_total", "B", 0},
+  {"high_free", "B", 0}
+};
+
+/*
+ * Return the RANGE of the last "NAME=RANGE" of 'ranges' for the metric
+ * 'name', NULL if there is none
+ */
+static const char *
+sm_range (const char *const *ranges, size_t nranges, const char *name)
+{
+  size_t len = strlen (name);
+  const char *found = NULL;
+  size_t i;
+
+  for (i = 0; i < nranges; i++)
+    if (strncmp (ranges[i], name, len) == 0 && ranges[i][len] == '=')
+      found = ranges[i] + len + 1;
+
+  return found;
+}
+
+/* Return the name of a metric of 'ranges' not in sm_metrics, or NULL */
+static const char *
+sm_unknown (const char *const *ranges, size_t nranges)
+{
+  size_t i, len;
+  int m;
+
+  for (i = 0; i < nranges; i++)
+    {
+      len = strcspn (ranges[i], "=");
+      for (m = 0; m < SM_METRICS; m++)
+	if (strlen (sm_metrics[m].name) == len
+	    && strncmp (ranges[i], sm_metrics[m].name, len) == 0)
+	  break;
+      if (m == SM_METRICS || ranges[i][len] != '=')
+	return ranges[i];
+    }
+
+  return NULL;
+}
+
+/*
+ * Check the sysinfo() metrics against the "NAME=RANGE" 'warnings' and
+ * 'criticals', the uptime against 'my_threshold' when it has no ranges
+ * of its own.
+ */
+int
+sysmetrics_check (const char *const *warnings, size_t nwarnings,
+		  const char *const *criticals, size_t ncriticals,
+		  const thresholds * my_threshold)
+{
+#if defined(HAVE_STRUCT_SYSINFO_WITH_UPTIME)
+  struct sysinfo info;
+  thresholds thr;
+  double values[SM_METRICS], unit;
+  const char *warning, *critical, *name;
+  char buf[128], alerts[512];
+  int status = STATE_OK, metric_status, m;
+  size_t len = 0;
+
+  if ((name = sm_unknown (warnings, nwarnings)) != NULL
+      || (name = sm_unknown (criticals, ncriticals)) != NULL)
+    {
+      printf ("UPTIME UNKNOWN: unknown metric '%s'\n", name);
+      return STATE_UNKNOWN;
+    }
+
+  if (0 != sysinfo (&info))
+    {
+      printf ("UPTIME UNKNOWN: can't get system uptime counter\n");
+      return STATE_UNKNOWN;
+    }
+
+  unit = info.mem_unit ? (double) info.mem_unit : 1.0;
+  values[SM_UPTIME] = (double) (info.uptime / 60);
+  values[SM_LOAD1] = (double) info.loads[0] / (double) (1 << SI_LOAD_SHIFT);
+  values[SM_LOAD5] = (double) info.loads[1] / (double) (1 << SI_LOAD_SHIFT);
+  values[SM_LOAD15] = (double) info.loads[2] / (double) (1 << SI_LOAD_SHIFT);
+  values[SM_TASKS] = (double) info.procs;
+  values[SM_RAM_TOTAL] = (double) info.totalram * unit;
+  values[SM_RAM_FREE] = (double) info.freeram * unit;
+  values[SM_RAM_SHARED] = (double) info.sharedram * unit;
+  values[SM_RAM_BUFFER] = (double) info.bufferram * unit;
+  values[SM_RAM_FREE_PCT] = (values[SM_RAM_TOTAL] > 0) ?
+    100.0 * values[SM_RAM_FREE] / values[SM_RAM_TOTAL] : 0;
+  values[SM_SWAP_TOTAL] = (double) info.totalswap * unit;
+  values[SM_SWAP_FREE] = (double) info.freeswap * unit;
+  values[SM_SWAP_USED_PCT] = (values[SM_SWAP_TOTAL] > 0) ?
+    100.0 * (values[SM_SWAP_TOTAL] - values[SM_SWAP_FREE])
+    / values[SM_SWAP_TOTAL] : 0;
+  values[SM_HIGH_TOTAL] = (double) info.totalhigh * unit;
+  values[SM_HIGH_FREE] = (double) info.freehigh * unit;
+
+  alerts[0] = '\0';
+  for (m = 0; m < SM_METRICS; m++)
+    {
+      warning = sm_range (warnings, nwarnings, sm_metrics[m].name);
+      critical = sm_range (criticals, ncriticals, sm_metrics[m].name);
+      if (m == SM_UPTIME && !warning && !critical)
+	metric_status = get_status (values[m], my_threshold);
+      else if (set_thresholds (&thr, warning, critical)
+	       == NP_RANGE_UNPARSEABLE)
+	{
+	  printf ("UPTIME UNKNOWN: invalid range for the metric '%s'\n",
+		  sm_metrics[m].name);
+	  return STATE_UNKNOWN;
+	}
+      else
+	metric_status = get_status (values[m], &thr);
+
+      if (metric_status > status)
+	status = metric_status;
+      if (metric_status != STATE_OK && len < sizeof (alerts))
+	{
+	  len += (size_t) snprintf (alerts + len, sizeof (alerts) - len,
+				    ", %s ", sm_metrics[m].name);
+	  if (len < sizeof (alerts))
+	    len += (size_t) snprintf (alerts + len, sizeof (alerts) - len,
+				      "%.*f", sm_metrics[m].decimals,
+				      values[m]);
+	}
+    }
+
+  printf ("UPTIME %s: %s, load %.2f %.2f %.2f, %.0f tasks%s|",
+	  status_message (status),
+	  sprint_uptime (buf, sizeof (buf), info.uptime),
+	  values[SM_LOAD1], values[SM_LOAD5], values[SM_LOAD15],
+	  values[SM_TASKS], alerts);
+  for (m = 0; m < SM_METRICS; m++)
+    printf ("%s%s=%.*f%s", (m > 0) ? " " : "", sm_metrics[m].name,
+	    sm_metrics[m].decimals, values[m], sm_metrics[m].uom);
+  putchar ('\n');
+
+  return status;
+#else
+  (void) warnings;
+  (void) nwarnings;
+  (void) criticals;
+  (void) ncriticals;
+  (void) my_threshold;
+  printf ("UPTIME UNKNOWN: sysinfo() is not available on this platform\n");
+  return STATE_UNKNOWN;
+#endif
+}
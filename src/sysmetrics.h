@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "nputils.h"
+
+#define SYSMETRICS_MAX_RANGES  64
+
+int sysmetrics_check (const char *const *, size_t, const char *const *,
+		      size_t, const thresholds *);
@@ -0,0 +1,234 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Multi-reader stress test of the shared memory seqlock
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Usage: test_shm [-r READERS] [-s SECONDS] [-u]
+ *
+ * One process publishes, with shm_write() and as fast as it can, the
+ * snapshots of a counter k whose fields are all derived from k, while
+ * READERS processes (4 by default) copy them with uptime_shm_read() for
+ * SECONDS (5).  A copy whose fields do not derive from the same k is torn.
+ * Prints, tab separated, the readers, the snapshots published, the copies
+ * and the torn copies, and fails if there is any.  With -u the readers
+ * copy the fields without the seqlock, to show that the test does catch
+ * the torn copies.
+ */
+
+#include "config.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nputils.h"
+#include "shmstate.h"
+
+#if HAVE_SHM_OPEN
+
+struct counters
+{
+  unsigned long long reads;
+  unsigned long long torn;
+};
+
+static volatile sig_atomic_t test_quit = FALSE;
+
+static void
+test_signal_handler (int sig __attribute__ ((__unused__)))
+{
+  test_quit = TRUE;
+}
+
+static void
+make_snapshot (struct uptime_shm_snapshot *snap, int64_t k)
+{
+  snap->boot_time = k;
+  snap->uptime = 2 * k;
+  snap->updated_at = 3 * k;
+  snap->state_changed_at = 4 * k;
+  snap->warning_at = 5 * k;
+  snap->critical_at = 6 * k;
+  snap->state = (int32_t) (k & 3);
+  snap->interval = (int32_t) (k & 0x7FFFFFFF);
+}
+
+static int
+is_torn (const struct uptime_shm_snapshot *snap)
+{
+  struct uptime_shm_snapshot expected;
+
+  make_snapshot (&expected, snap->boot_time);
+  return memcmp (snap, &expected, sizeof (expected)) != 0;
+}
+
+/* Copy the snapshot field by field, racing with the writer */
+static void
+unsafe_read (const struct uptime_shm *shm, struct uptime_shm_snapshot *snap)
+{
+  const volatile struct uptime_shm_snapshot *src = &shm->snap;
+
+  snap->boot_time = src->boot_time;
+  snap->uptime = src->uptime;
+  snap->updated_at = src->updated_at;
+  snap->state_changed_at = src->state_changed_at;
+  snap->warning_at = src->warning_at;
+  snap->critical_at = src->critical_at;
+  snap->state = src->state;
+  snap->interval = src->interval;
+}
+
+static void
+reader (const char *name, struct counters *counters, int unsafe)
+{
+  const struct uptime_shm *shm;
+  struct uptime_shm_snapshot snap;
+
+  if (NULL == (shm = uptime_shm_open (name)))
+    _exit (STATE_UNKNOWN);
+
+  while (!test_quit)
+    {
+      if (unsafe)
+	unsafe_read (shm, &snap);
+      else if (uptime_shm_read (shm, &snap) < 0)
+	continue;
+      counters->reads++;
+      if (is_torn (&snap))
+	counters->torn++;
+    }
+  _exit (STATE_OK);
+}
+
+int
+main (int argc, char **argv)
+{
+  struct uptime_shm *shm;
+  struct uptime_shm_snapshot snap;
+  struct counters *counters;
+  struct sigaction sa;
+  unsigned long long reads = 0, torn = 0;
+  long readers = 4, seconds = 5, i;
+  int64_t k = 0;
+  int c, fd, unsafe = FALSE, status = STATE_OK, wstatus;
+  char name[64];
+  pid_t *pids;
+  time_t end;
+
+  while ((c = getopt (argc, argv, "r:s:u")) != -1)
+    switch (c)
+      {
+      case 'r':
+	readers = strtol (optarg, NULL, 10);
+	break;
+      case 's':
+	seconds = strtol (optarg, NULL, 10);
+	break;
+      case 'u':
+	unsafe = TRUE;
+	break;
+      default:
+	readers = 0;
+	break;
+      }
+
+  if (optind != argc || readers <= 0 || seconds <= 0)
+    {
+      fprintf (stderr, "Usage: %s [-r READERS] [-s SECONDS] [-u]\n",
+	       argv[0]);
+      return STATE_UNKNOWN;
+    }
+
+  snprintf (name, sizeof (name), "/test_shm.%ld", (long) getpid ());
+  if ((fd = shm_open (name, O_CREAT | O_EXCL | O_RDWR, 0600)) < 0 ||
+      ftruncate (fd, sizeof (struct uptime_shm)) < 0)
+    {
+      perror (name);
+      return STATE_UNKNOWN;
+    }
+  shm = mmap (NULL, sizeof (struct uptime_shm), PROT_READ | PROT_WRITE,
+	      MAP_SHARED, fd, 0);
+  close (fd);
+  counters = mmap (NULL, (size_t) readers * sizeof (*counters),
+		   PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  pids = calloc ((size_t) readers, sizeof (*pids));
+  if (MAP_FAILED == shm || MAP_FAILED == counters || NULL == pids)
+    {
+      perror ("test_shm");
+      shm_unlink (name);
+      return STATE_UNKNOWN;
+    }
+
+  memset (shm, 0, sizeof (*shm));
+  shm->version = UPTIME_SHM_VERSION;
+  make_snapshot (&snap, ++k);
+  shm_write (shm, &snap);
+  __atomic_store_n (&shm->magic, UPTIME_SHM_MAGIC, __ATOMIC_RELEASE);
+
+  memset (&sa, 0, sizeof (sa));
+  sa.sa_handler = test_signal_handler;
+  sigaction (SIGTERM, &sa, NULL);
+
+  for (i = 0; i < readers; i++)
+    if ((pids[i] = fork ()) == 0)
+      reader (name, &counters[i], unsafe);
+
+  for (end = time (NULL) + seconds; time (NULL) < end;)
+    {
+      make_snapshot (&snap, ++k);
+      shm_write (shm, &snap);
+    }
+
+  for (i = 0; i < readers; i++)
+    if (pids[i] > 0)
+      {
+	kill (pids[i], SIGTERM);
+	if (waitpid (pids[i], &wstatus, 0) < 0 || !WIFEXITED (wstatus)
+	    || WEXITSTATUS (wstatus) != STATE_OK)
+	  status = STATE_UNKNOWN;
+	reads += counters[i].reads;
+	torn += counters[i].torn;
+      }
+    else
+      status = STATE_UNKNOWN;
+  shm_unlink (name);
+
+  printf ("# readers\tsnapshots\tcopies\ttorn\n");
+  printf ("%ld\t%lld\t%llu\t%llu\n", readers, (long long) k, reads, torn);
+
+  if (torn > 0 && status == STATE_OK)
+    status = STATE_CRITICAL;
+  return status;
+}
+
+#else
+
+int
+main (void)
+{
+  fputs ("POSIX shared memory is not supported\n", stderr);
+  return STATE_UNKNOWN;
+}
+
+#endif /* HAVE_SHM_OPEN */
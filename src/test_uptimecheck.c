@@ -0,0 +1,191 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Threaded test of the reentrancy of libuptimecheck
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Usage: test_uptimecheck [-n CHECKS] [-t THREADS]
+ *
+ * THREADS threads (8 by default) run CHECKS checks (4000000) in all, each
+ * with its own thresholds and uptime taken in turn from a table, through
+ * uptimecheck_set_thresholds() and uptimecheck_format(), and compare every
+ * line and state with the ones computed by a single thread beforehand.
+ * One check in a thousand is a full uptimecheck_run().  Prints, tab
+ * separated, the threads, the checks, the checks per second and the
+ * mismatches, and fails if there is any: a shared mutable state would
+ * sooner or later mix up the results of two threads.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include "uptimecheck.h"
+
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+
+#define TEST_RANGES   6
+#define TEST_UPTIMES  7
+#define TEST_CASES    (TEST_RANGES * TEST_UPTIMES)
+
+static const char *const ranges[TEST_RANGES][2] = {
+  {NULL, NULL},
+  {"30:", "15:"},
+  {"@0:60", "@0:10"},
+  {"~:100000", "~:200000"},
+  {"1440:", "60:"},
+  {"10:20", "5:30"},
+};
+
+static const time_t uptimes[TEST_UPTIMES] = {
+  59, 600, 3599, 86400, 86400 * 7 + 3600 * 5 + 60 * 3, 86400 * 400 + 61,
+  (time_t) 86400 * 365 * 30
+};
+
+struct expected
+{
+  char line[UPTIMECHECK_LINE_MAX];
+  int state;
+};
+
+static struct expected expected[TEST_CASES];
+static unsigned long checks_per_thread;
+static unsigned long mismatches;
+
+static int
+run_case (unsigned long n, char *line, int *state)
+{
+  const char *const *r = ranges[(n / TEST_UPTIMES) % TEST_RANGES];
+  uptimecheck_thresholds thr;
+
+  if (uptimecheck_set_thresholds (&thr, r[0], r[1]) != UPTIMECHECK_OK)
+    return -1;
+  return uptimecheck_format (line, UPTIMECHECK_LINE_MAX,
+			     uptimes[n % TEST_UPTIMES], &thr, state);
+}
+
+static void *
+worker (void *arg)
+{
+  unsigned long n, start = (unsigned long) arg, bad = 0;
+  uptimecheck_thresholds thr;
+  char line[UPTIMECHECK_LINE_MAX];
+  int state;
+
+  for (n = start; n < start + checks_per_thread; n++)
+    {
+      if (n % 1000 == 999)
+	{
+	  uptimecheck_set_thresholds (&thr, "30:", "15:");
+	  if (uptimecheck_run (line, sizeof (line), &thr, &state)
+	      != UPTIMECHECK_OK || strncmp (line, "UPTIME ", 7)
+	      || state < UPTIMECHECK_STATE_OK
+	      || state > UPTIMECHECK_STATE_CRITICAL)
+	    bad++;
+	  continue;
+	}
+      if (run_case (n, line, &state) != UPTIMECHECK_OK
+	  || state != expected[n % TEST_CASES].state
+	  || strcmp (line, expected[n % TEST_CASES].line))
+	bad++;
+    }
+  __atomic_fetch_add (&mismatches, bad, __ATOMIC_RELAXED);
+
+  return NULL;
+}
+
+int
+main (int argc, char **argv)
+{
+  unsigned long checks = 4000000, threads = 8, i;
+  struct timespec t0, t1;
+  pthread_t *tids;
+  double secs;
+  int c;
+
+  while ((c = getopt (argc, argv, "n:t:")) != -1)
+    switch (c)
+      {
+      case 'n':
+	checks = strtoul (optarg, NULL, 10);
+	break;
+      case 't':
+	threads = strtoul (optarg, NULL, 10);
+	break;
+      default:
+	checks = 0;
+	break;
+      }
+
+  if (optind != argc || checks == 0 || threads == 0 || threads > checks)
+    {
+      fprintf (stderr, "Usage: %s [-n CHECKS] [-t THREADS]\n", argv[0]);
+      return UPTIMECHECK_STATE_UNKNOWN;
+    }
+
+  for (i = 0; i < TEST_CASES; i++)
+    if (run_case (i, expected[i].line, &expected[i].state)
+	!= UPTIMECHECK_OK)
+      {
+	fprintf (stderr, "test case %lu failed\n", i);
+	return UPTIMECHECK_STATE_UNKNOWN;
+      }
+
+  checks_per_thread = checks / threads;
+  if ((tids = calloc (threads, sizeof (*tids))) == NULL)
+    return UPTIMECHECK_STATE_UNKNOWN;
+
+  clock_gettime (CLOCK_MONOTONIC, &t0);
+  for (i = 0; i < threads; i++)
+    if (pthread_create (&tids[i], NULL, worker,
+			(void *) (i * checks_per_thread)) != 0)
+      {
+	perror ("pthread_create");
+	return UPTIMECHECK_STATE_UNKNOWN;
+      }
+  for (i = 0; i < threads; i++)
+    pthread_join (tids[i], NULL);
+  clock_gettime (CLOCK_MONOTONIC, &t1);
+  secs = (double) (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+  printf ("# threads\tchecks\tchecks/s\tmismatches\n");
+  printf ("%lu\t%lu\t%.0f\t%lu\n", threads, checks_per_thread * threads,
+	  (double) (checks_per_thread * threads) / secs, mismatches);
+  free (tids);
+
+  return mismatches ? UPTIMECHECK_STATE_CRITICAL : UPTIMECHECK_STATE_OK;
+}
+
+#else
+
+int
+main (void)
+{
+  fputs ("the threaded test requires POSIX threads\n", stderr);
+  return UPTIMECHECK_STATE_UNKNOWN;
+}
+
+#endif /* HAVE_PTHREAD_H && HAVE_PTHREAD */
@@ -0,0 +1,165 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Writer of the uptime metrics for the Prometheus textfile collector
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The file holds the boot time and the check state only (the collector
+ * already exports node_time_seconds), so that its content, and thus the
+ * file itself, only changes at reboots and when a threshold is crossed.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "metrics.h"
+#include "nputils.h"
+#include "textfile.h"
+#include "uptime.h"
+
+#define TEXTFILE_NAME  "uptime.prom"
+
+static volatile sig_atomic_t textfile_quit = FALSE;
+
+static void
+textfile_signal_handler (int sig __attribute__ ((__unused__)))
+{
+  textfile_quit = TRUE;
+}
+
+/*
+ * Atomically replace 'path' with 'data' through the temporary file 'tmp'.
+ * Returns 0 if okay, otherwise -1
+ */
+static int
+write_file (const char *dir, const char *path, const char *tmp,
+	    const char *data, size_t len, int do_fsync)
+{
+  ssize_t n;
+  int fd;
+
+  if ((fd = open (tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+    return -1;
+
+  while (len > 0)
+    {
+      if ((n = write (fd, data, len)) < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  break;
+	}
+      data += n;
+      len -= n;
+    }
+
+  if (len > 0 || (do_fsync && fsync (fd) < 0))
+    {
+      close (fd);
+      unlink (tmp);
+      return -1;
+    }
+  if (close (fd) < 0 || rename (tmp, path) < 0)
+    {
+      unlink (tmp);
+      return -1;
+    }
+
+  /* make the rename itself durable */
+  if (do_fsync && (fd = open (dir, O_RDONLY)) >= 0)
+    {
+      fsync (fd);
+      close (fd);
+    }
+
+  return 0;
+}
+
+int
+textfile_writer (const char *dir, unsigned int interval, int do_fsync,
+		 const thresholds * my_threshold)
+{
+  char content[METRICS_BUFSIZE], written[METRICS_BUFSIZE];
+  char *path, *tmp;
+  size_t len, written_len = 0;
+  struct sigaction sa;
+  time_t uptime_secs, boot_time, last_boot_time = 0;
+  int status = STATE_OK;
+
+  len = strlen (dir) + sizeof ("/." TEXTFILE_NAME ".tmp");
+  path = malloc (len);
+  tmp = malloc (len);
+  if (NULL == path || NULL == tmp)
+    {
+      perror ("cannot allocate memory");
+      return STATE_UNKNOWN;
+    }
+  /* the collector only reads the files with the extension .prom */
+  snprintf (path, len, "%s/%s", dir, TEXTFILE_NAME);
+  snprintf (tmp, len, "%s/.%s.tmp", dir, TEXTFILE_NAME);
+
+  memset (&sa, 0, sizeof (sa));
+  sa.sa_handler = textfile_signal_handler;
+  sigaction (SIGINT, &sa, NULL);
+  sigaction (SIGTERM, &sa, NULL);
+
+  do
+    {
+      uptime_secs = uptime ();
+      boot_time = time (NULL) - uptime_secs;
+      /* the two clocks are not in step: ignore the rounding jitter */
+      if (labs ((long) (boot_time - last_boot_time)) <= 1)
+	boot_time = last_boot_time;
+      last_boot_time = boot_time;
+
+      len = sprint_metrics (content, sizeof (content), uptime_secs,
+			    boot_time, 0, my_threshold);
+      if (len != written_len || memcmp (content, written, len))
+	{
+	  if (write_file (dir, path, tmp, content, len, do_fsync) < 0)
+	    {
+	      perror (path);
+	      status = STATE_UNKNOWN;
+	      written_len = 0;
+	    }
+	  else
+	    {
+	      memcpy (written, content, len);
+	      written_len = len;
+	      status = STATE_OK;
+	    }
+	}
+
+      if (interval > 0)
+	sleep (interval);
+    }
+  while (interval > 0 && !textfile_quit);
+
+  free (path);
+  free (tmp);
+
+  return status;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+#include "nputils.h"
+
+int textfile_writer (const char *, unsigned int, int,
+		     const thresholds *);
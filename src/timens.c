@@ -0,0 +1,324 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Apparent uptime of the processes living in other time namespaces
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A time namespace (Linux 5.6) shifts CLOCK_BOOTTIME and CLOCK_MONOTONIC
+ * by the offsets listed in /proc/PID/timens_offsets, relative to the
+ * initial namespace, so a container sees the uptime
+ *
+ *   own uptime - own boottime offset + container boottime offset
+ *
+ * which is computed here without entering the namespace.  setns() into a
+ * time namespace is refused to a multithreaded process (EUSERS), so the
+ * namespace files that cannot be mapped to a pid (a bind mount of the
+ * namespace) are read by a child forked for the purpose, that enters the
+ * namespace and sends back its CLOCK_BOOTTIME; no program is executed.
+ *
+ * The targets are shared among --threads threads, each taking the next
+ * one from a common counter.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include "nputils.h"
+#include "procscan.h"
+#include "timens.h"
+#include "uptime.h"
+
+#define TIMENS_OFFSETS  "timens_offsets"
+
+struct tn_batch
+{
+  int procfd;
+  time_t uptime;		/* our own uptime and boottime offset */
+  long long offset;
+  struct stat own_ns;
+  struct age_target *targets;	/* pids or time namespace paths, and
+				   the uptimes seen in them */
+  size_t ntargets;
+  size_t next;			/* first target not taken yet */
+};
+
+/*
+ * Read the boottime offset, in seconds, of the time namespace of 'pid'
+ * ("self" for the current process).  Returns 0 if okay
+ */
+static int
+tn_read_offset (int procfd, const char *pid, long long *offset)
+{
+  char path[64], buf[256], *line, *endptr;
+  ssize_t len;
+  int fd;
+
+  *offset = 0;
+  snprintf (path, sizeof (path), "%s/" TIMENS_OFFSETS, pid);
+  if ((fd = openat (procfd, path, O_RDONLY | O_CLOEXEC)) < 0)
+    {
+      /* no time namespaces in this kernel: the process is in ours */
+      if (errno == ENOENT && faccessat (procfd, pid, F_OK, 0) == 0)
+	return 0;
+      return -1;
+    }
+  len = read (fd, buf, sizeof (buf) - 1);
+  close (fd);
+  if (len < 0)
+    return -1;
+  buf[len] = '\0';
+
+  /* "monotonic <secs> <nsecs>\nboottime <secs> <nsecs>\n" */
+  for (line = buf; line; line = strchr (line, '\n'))
+    {
+      if (*line == '\n')
+	line++;
+      if (strncmp (line, "boottime", 8) == 0)
+	{
+	  *offset = strtoll (line + 8, &endptr, 10);
+	  return (endptr == line + 8) ? -1 : 0;
+	}
+    }
+
+  return -1;
+}
+
+/*
+ * Return the pid named by 'path' if it is PROC_ROOT/PID/ns/time (or just
+ * PID), zero otherwise
+ */
+static unsigned long
+tn_path_pid (const char *path)
+{
+  const char *p = path;
+  char *endptr;
+  unsigned long pid;
+
+  if (strncmp (p, PROC_ROOT "/", sizeof (PROC_ROOT)) == 0)
+    p += sizeof (PROC_ROOT);
+  pid = strtoul (p, &endptr, 10);
+  if (endptr == p || *p == '+' || *p == '-')
+    return 0;
+  if (*endptr == '\0' && p == path)
+    return pid;
+  return (p != path && strcmp (endptr, "/ns/time") == 0) ? pid : 0;
+}
+
+/*
+ * Read CLOCK_BOOTTIME in the time namespace 'fd' from a child process.
+ * Returns 0 if okay
+ */
+static int
+tn_read_clock (int fd, time_t * uptime_secs)
+{
+#if HAVE_SETNS && defined CLONE_NEWTIME && defined CLOCK_BOOTTIME
+  struct timespec ts;
+  int pipefd[2], wstatus;
+  ssize_t len;
+  pid_t pid;
+
+  if (pipe (pipefd) < 0)
+    return -1;
+  if ((pid = fork ()) < 0)
+    {
+      close (pipefd[0]);
+      close (pipefd[1]);
+      return -1;
+    }
+  if (pid == 0)
+    {
+      /* only async-signal-safe calls here: the parent may have threads */
+      close (pipefd[0]);
+      if (setns (fd, CLONE_NEWTIME) < 0
+	  || clock_gettime (CLOCK_BOOTTIME, &ts) < 0
+	  || write (pipefd[1], &ts, sizeof (ts)) != sizeof (ts))
+	_exit (1);
+      _exit (0);
+    }
+
+  close (pipefd[1]);
+  len = read (pipefd[0], &ts, sizeof (ts));
+  close (pipefd[0]);
+  while (waitpid (pid, &wstatus, 0) < 0 && errno == EINTR)
+    ;
+  if (len != sizeof (ts))
+    return -1;
+
+  *uptime_secs = ts.tv_sec;
+  return 0;
+#else
+  (void) fd;
+  (void) uptime_secs;
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+static void
+tn_resolve (struct tn_batch *batch, struct age_target *target)
+{
+  char pid[32];
+  struct stat st;
+  long long offset;
+  unsigned long n;
+  int fd;
+
+  target->error = -1;
+  if ((n = tn_path_pid (target->name)) > 0)
+    {
+      snprintf (pid, sizeof (pid), "%lu", n);
+      if (tn_read_offset (batch->procfd, pid, &offset) == 0)
+	{
+	  offset += batch->uptime - batch->offset;
+	  target->age = (offset > 0) ? (time_t) offset : 0;
+	  target->error = 0;
+	}
+      return;
+    }
+
+  if ((fd = open (target->name, O_RDONLY | O_CLOEXEC)) < 0)
+    return;
+  if (fstat (fd, &st) == 0)
+    {
+      if (st.st_dev == batch->own_ns.st_dev
+	  && st.st_ino == batch->own_ns.st_ino)
+	{
+	  target->age = batch->uptime;
+	  target->error = 0;
+	}
+      else
+	target->error = tn_read_clock (fd, &target->age);
+    }
+  close (fd);
+}
+
+static void *
+tn_work (void *arg)
+{
+  struct tn_batch *batch = arg;
+  size_t i;
+
+  while ((i = __atomic_fetch_add (&batch->next, 1, __ATOMIC_RELAXED))
+	 < batch->ntargets)
+    tn_resolve (batch, &batch->targets[i]);
+
+  return NULL;
+}
+
+/*
+ * Check the uptime seen by the processes, or in the time namespaces, of
+ * the comma separated 'list', with 'threads' threads.
+ */
+int
+timens_check (const char *list, const char *proc_root, unsigned int threads,
+	      const thresholds * my_threshold)
+{
+  char *names, *name, *saveptr = NULL, path[PATH_MAX];
+  struct tn_batch batch;
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+  pthread_t tid[PROCSCAN_MAX_THREADS];
+  int threaded[PROCSCAN_MAX_THREADS] = { 0 };
+#endif
+  size_t i;
+  int status;
+
+  memset (&batch, 0, sizeof (batch));
+  if (UPTIME_RET_FAIL == (batch.uptime = uptime ()))
+    {
+      printf ("UPTIME UNKNOWN: can't get system uptime counter\n");
+      return STATE_UNKNOWN;
+    }
+  if ((batch.procfd = open (proc_root, O_RDONLY | O_DIRECTORY | O_CLOEXEC))
+      < 0 || tn_read_offset (batch.procfd, "self", &batch.offset) < 0)
+    {
+      if (batch.procfd >= 0)
+	close (batch.procfd);
+      printf ("UPTIME UNKNOWN: cannot read the time namespaces in %s\n",
+	      proc_root);
+      return STATE_UNKNOWN;
+    }
+  snprintf (path, sizeof (path), "%s/self/ns/time", proc_root);
+  if (stat (path, &batch.own_ns) < 0)
+    memset (&batch.own_ns, 0, sizeof (batch.own_ns));
+
+  if ((names = strdup (list)) == NULL
+      || (batch.targets = calloc (strlen (list) / 2 + 1,
+				  sizeof (struct age_target))) == NULL)
+    {
+      free (names);
+      close (batch.procfd);
+      printf ("UPTIME UNKNOWN: out of memory\n");
+      return STATE_UNKNOWN;
+    }
+  for (name = strtok_r (names, ",", &saveptr); name;
+       name = strtok_r (NULL, ",", &saveptr))
+    batch.targets[batch.ntargets++].name = name;
+  if (batch.ntargets == 0)
+    {
+      free (batch.targets);
+      free (names);
+      close (batch.procfd);
+      printf ("UPTIME UNKNOWN: no process nor time namespace given\n");
+      return STATE_UNKNOWN;
+    }
+
+#if !(HAVE_PTHREAD_H && HAVE_PTHREAD)
+  threads = 1;
+#endif
+  if (threads < 1)
+    threads = 1;
+  if (threads > batch.ntargets)
+    threads = (unsigned int) batch.ntargets;
+  if (threads > PROCSCAN_MAX_THREADS)
+    threads = PROCSCAN_MAX_THREADS;
+
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+  for (i = 1; i < threads; i++)
+    threaded[i] = (pthread_create (&tid[i], NULL, tn_work, &batch) == 0);
+#endif
+  tn_work (&batch);
+#if HAVE_PTHREAD_H && HAVE_PTHREAD
+  for (i = 1; i < threads; i++)
+    if (threaded[i])
+      pthread_join (tid[i], NULL);
+#endif
+  close (batch.procfd);
+
+  status = print_age_targets ("namespaces", batch.targets, batch.ntargets,
+			      my_threshold);
+
+  free (batch.targets);
+  free (names);
+
+  return status;
+}
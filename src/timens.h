@@ -0,0 +1,6 @@
+#pragma once
+
+#include "nputils.h"
+
+int timens_check (const char *, const char *, unsigned int,
+		  const thresholds *);
@@ -0,0 +1,316 @@
+/*
+ * License: GPL
+ * Copyright (c) 2010,2012,2013 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Functions returning the system uptime
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#if HAVE_KSTAT_H
+#include <kstat.h>
+#endif
+
+#if HAVE_LIBPERFSTAT
+#include <sys/protosw.h>
+#include <libperfstat.h>
+#endif
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if HAVE_SYS_SYSINFO_H
+#include <sys/sysinfo.h>
+#endif
+
+#if TIME_WITH_SYS_TIME
+#include <sys/time.h>
+#include <time.h>
+#else
+#if HAVE_SYS_TIME_H
+#include <sys/time.h>
+#else
+#include <time.h>
+#endif
+#endif
+
+#include <unistd.h>
+
+#ifdef HAVE_SYS_PARAM_H
+#include <sys/param.h>
+#endif
+
+#if HAVE_SYS_SYSCTL_H
+#include <sys/sysctl.h>
+#endif
+
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+
+#include "bootcache.h"
+#include "nputils.h"
+#include "probes.h"
+#include "uptime.h"
+
+/*
+ * The uptime sources.  Every source available on the platform is compiled
+ * in: the first one of the table that works is used by default, and
+ * uptime_set_source() can select another one at startup.
+ */
+
+#if defined(HAVE_CLOCK_GETTIME_MONOTONIC) && defined(CLOCK_BOOTTIME)
+/* Linux: served by the vDSO without a syscall, includes the suspend time */
+static time_t
+uptime_boottime (void)
+{
+  struct timespec t;
+
+  if (0 != clock_gettime (CLOCK_BOOTTIME, &t) || t.tv_sec <= 0)
+    return UPTIME_RET_FAIL;
+
+  return t.tv_sec;
+}
+#endif
+
+#if defined(HAVE_STRUCT_SYSINFO_WITH_UPTIME)	/* Linux */
+static time_t
+uptime_sysinfo (void)
+{
+  struct sysinfo info;
+
+  if (0 != sysinfo (&info))
+    return UPTIME_RET_FAIL;
+
+  return (time_t) info.uptime;
+}
+#endif
+
+#if defined(__linux__)
+/* Linux: the first field of /proc/uptime, read without stdio */
+static time_t
+uptime_procfs (void)
+{
+  char buf[64], *p;
+  ssize_t len;
+  time_t secs = 0;
+  int fd;
+
+  if (-1 == (fd = open ("/proc/uptime", O_RDONLY | O_CLOEXEC)))
+    return UPTIME_RET_FAIL;
+  len = read (fd, buf, sizeof (buf) - 1);
+  close (fd);
+  if (len <= 0)
+    return UPTIME_RET_FAIL;
+  buf[len] = '\0';
+
+  for (p = buf; *p >= '0' && *p <= '9'; p++)
+    secs = secs * 10 + (*p - '0');
+
+  return (*p == '.' || *p == ' ') ? secs : UPTIME_RET_FAIL;
+}
+#endif
+
+#if defined(HAVE_FUNCTION_SYSCTL_KERN_BOOTTIME)	/* FreeBSD */
+static time_t
+uptime_sysctl (void)
+{
+  int mib[] = { CTL_KERN, KERN_BOOTTIME };
+  struct timeval system_uptime;
+  size_t len = sizeof (system_uptime);
+
+  if (0 != sysctl (mib, 2, &system_uptime, &len, NULL, 0))
+    return UPTIME_RET_FAIL;
+
+  return (time (NULL) - system_uptime.tv_sec);
+}
+#endif
+
+#if defined(HAVE_KSTAT_H)	/* Solaris */
+static time_t
+uptime_kstat (void)
+{
+  kstat_ctl_t *kc;
+  kstat_t *ksp;
+  kstat_named_t *knp;
+
+  time_t now;
+
+  if (NULL == (kc = kstat_open ()))
+    return UPTIME_RET_FAIL;
+
+  if (NULL !=
+      (ksp = kstat_lookup (kc, (char *) "unix", 0, (char *) "system_misc")))
+    {
+      if (-1 != kstat_read (kc, ksp, 0))
+	{
+	  if (NULL != (knp = kstat_data_lookup (ksp, (char *) "boot_time")))
+	    {
+	      time (&now);
+	      kstat_close (kc);
+	      return (difftime (now, (time_t) knp->value.ul));
+	    }
+	}
+    }
+
+  kstat_close (kc);
+  return UPTIME_RET_FAIL;
+}
+#endif
+
+#if defined(HAVE_LIBPERFSTAT)	/* AIX */
+static time_t
+uptime_perfstat (void)
+{
+  long hertz = 0;
+  perfstat_cpu_total_t ps_cpu_total;
+
+  // get the number of clock ticks per second
+  hertz = sysconf (_SC_CLK_TCK);
+
+  if (-1 ==
+      perfstat_cpu_total (NULL, &ps_cpu_total, sizeof (ps_cpu_total), 1))
+    return UPTIME_RET_FAIL;
+
+  // lbolt contains the number of ticks since last reboot
+  return ps_cpu_total.lbolt / hertz;
+}
+#endif
+
+#if defined(HAVE_CLOCK_GETTIME_MONOTONIC)	/* POSIX.1-2001 */
+/* does not include the suspend time on Linux */
+static time_t
+uptime_monotonic (void)
+{
+  struct timespec t;
+
+  if (0 != clock_gettime (CLOCK_MONOTONIC, &t) || t.tv_sec <= 0)
+    return UPTIME_RET_FAIL;
+
+  return t.tv_sec;
+}
+#endif
+
+/* In order of preference */
+const struct uptime_source uptime_sources[] = {
+#if defined(HAVE_CLOCK_GETTIME_MONOTONIC) && defined(CLOCK_BOOTTIME)
+  {"boottime", "clock_gettime(CLOCK_BOOTTIME)", uptime_boottime},
+#endif
+#if defined(HAVE_STRUCT_SYSINFO_WITH_UPTIME)
+  {"sysinfo", "sysinfo() uptime", uptime_sysinfo},
+#endif
+#if defined(__linux__)
+  {"procfs", "/proc/uptime", uptime_procfs},
+#endif
+#if defined(HAVE_FUNCTION_SYSCTL_KERN_BOOTTIME)
+  {"sysctl", "sysctl KERN_BOOTTIME", uptime_sysctl},
+#endif
+#if defined(HAVE_KSTAT_H)
+  {"kstat", "kstat unix:0:system_misc:boot_time", uptime_kstat},
+#endif
+#if defined(HAVE_LIBPERFSTAT)
+  {"perfstat", "perfstat_cpu_total() lbolt", uptime_perfstat},
+#endif
+#if defined(HAVE_CLOCK_GETTIME_MONOTONIC)
+  {"monotonic", "clock_gettime(CLOCK_MONOTONIC)", uptime_monotonic},
+#endif
+  {NULL, NULL, NULL}
+};
+
+/* The source selected by uptime_set_source(), if any */
+static const struct uptime_source *selected_source;
+
+const struct uptime_source *
+uptime_find_source (const char *name)
+{
+  const struct uptime_source *src;
+
+  for (src = uptime_sources; src->name; src++)
+    if (!strcmp (src->name, name))
+      return src;
+
+  return NULL;
+}
+
+/*
+ * Select the source used by uptime(), or go back to the default with
+ * 'name' NULL.  Returns -1 if the source is unknown or does not work on
+ * the running host.  Not thread-safe: call it at startup.
+ */
+int
+uptime_set_source (const char *name)
+{
+  const struct uptime_source *src;
+
+  if (NULL == name)
+    {
+      selected_source = NULL;
+      return 0;
+    }
+
+  if (NULL == (src = uptime_find_source (name))
+      || UPTIME_RET_FAIL == src->get ())
+    return -1;
+
+  selected_source = src;
+  return 0;
+}
+
+/* Read the uptime from 'src', between the source probes */
+static time_t
+uptime_source_get (const struct uptime_source *src)
+{
+  time_t secs;
+
+  UPTIME_PROBE2 (source__entry, (int) (src - uptime_sources), src->name);
+  secs = src->get ();
+  UPTIME_PROBE3 (source__return, (int) (src - uptime_sources), src->name,
+		 (long long) secs);
+
+  return secs;
+}
+
+static time_t
+uptime_from_sources (void)
+{
+  const struct uptime_source *src;
+  time_t secs;
+
+  if (selected_source)
+    return uptime_source_get (selected_source);
+
+  for (src = uptime_sources; src->name; src++)
+    if (UPTIME_RET_FAIL != (secs = uptime_source_get (src)))
+      return secs;
+
+  return UPTIME_RET_FAIL;
+}
+
+time_t
+uptime (void)
+{
+  time_t secs;
+
+  UPTIME_PROBE0 (uptime__entry);
+  if (bootcache_enabled ())
+    secs = bootcache_uptime (uptime_from_sources);
+  else
+    secs = uptime_from_sources ();
+  UPTIME_PROBE1 (uptime__return, (long long) secs);
+
+  return secs;
+}
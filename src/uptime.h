@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stddef.h>
+#include <time.h>
+
+#include "nputils.h"
+
+/* assume uptime never be zero seconds in practice */
+#define UPTIME_RET_FAIL  0
+
+struct uptime_source
+{
+  const char *name;
+  const char *description;
+  time_t (*get) (void);
+};
+
+/* terminated by an entry with a NULL name */
+extern const struct uptime_source uptime_sources[];
+
+/* a target of the checks of many ages: a container, a namespace... */
+struct age_target
+{
+  const char *name;
+  time_t age;			/* seconds */
+  int error;			/* the age could not be read */
+};
+
+const struct uptime_source *uptime_find_source (const char *);
+int uptime_set_source (const char *);
+time_t uptime (void);
+const char *status_message (int);
+char *sprint_uptime (char *, size_t, time_t);
+size_t sprint_check_line (char *, size_t, time_t, const thresholds *,
+			  int *);
+int sprint_check_result (char *, size_t, time_t, const thresholds *);
+int print_age_targets (const char *, const struct age_target *, size_t,
+		       const thresholds *);
+int sprint_reboots_result (char *, size_t, time_t, unsigned int, int,
+			   const char *, const thresholds *,
+			   const thresholds *);
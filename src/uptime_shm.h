@@ -0,0 +1,136 @@
+#pragma once
+
+/*
+ * Layout and reader of the shared memory segment published by
+ * 'check_uptime --publish-shm NAME'.  The segment is protected by a seqlock:
+ * the publisher makes 'seq' odd while it updates the snapshot, so a reader
+ * retries whenever 'seq' is odd or changed during its copy, for at most
+ * UPTIME_SHM_READ_TIMEOUT_MS.
+ */
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define UPTIME_SHM_MAGIC    0x55505449UL	/* "UPTI" */
+#define UPTIME_SHM_VERSION  1
+/* a snapshot older than this many intervals (and a second) is stale */
+#define UPTIME_SHM_MAX_MISSED  3
+/* a reader spins this many times on a write in progress, then yields the
+   CPU to the publisher, and gives up after this many milliseconds: the
+   publisher died in the middle of a write */
+#define UPTIME_SHM_SPINS       1000
+#define UPTIME_SHM_READ_TIMEOUT_MS  100
+
+struct uptime_shm_snapshot
+{
+  int64_t boot_time;		/* seconds since the epoch */
+  int64_t uptime;		/* seconds, at 'updated_at' */
+  int64_t updated_at;
+  int64_t state_changed_at;	/* last change of 'state' */
+  int64_t warning_at;		/* last time 'state' became WARNING */
+  int64_t critical_at;		/* last time 'state' became CRITICAL */
+  int32_t state;		/* Nagios state (publisher thresholds) */
+  int32_t interval;		/* seconds between two updates */
+};
+
+struct uptime_shm
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t seq;
+  uint32_t reserved;
+  struct uptime_shm_snapshot snap;
+};
+
+#define UPTIME_SHM_FIELDS \
+  (sizeof (struct uptime_shm_snapshot) / sizeof (int64_t))
+
+/* Map read-only the segment 'name'.  Returns NULL on error */
+static inline const struct uptime_shm *
+uptime_shm_open (const char *name)
+{
+  void *addr;
+  int fd;
+
+  if ((fd = shm_open (name, O_RDONLY, 0)) < 0)
+    return NULL;
+  addr = mmap (NULL, sizeof (struct uptime_shm), PROT_READ, MAP_SHARED, fd,
+	       0);
+  close (fd);
+
+  if (MAP_FAILED == addr ||
+      ((const struct uptime_shm *) addr)->magic != UPTIME_SHM_MAGIC ||
+      ((const struct uptime_shm *) addr)->version != UPTIME_SHM_VERSION)
+    {
+      if (MAP_FAILED != addr)
+	munmap (addr, sizeof (struct uptime_shm));
+      return NULL;
+    }
+
+  return (const struct uptime_shm *) addr;
+}
+
+/*
+ * Copy a consistent snapshot of the segment, without any syscall unless
+ * a write is in progress.  Returns 0 if okay, or -1 if nothing has been
+ * published yet or no consistent copy could be made in time
+ */
+static inline int
+uptime_shm_read (const struct uptime_shm *shm,
+		 struct uptime_shm_snapshot *snap)
+{
+  const int64_t *src = (const int64_t *) &shm->snap;
+  union
+  {
+    struct uptime_shm_snapshot snap;
+    int64_t words[UPTIME_SHM_FIELDS];
+  } copy;
+  struct timespec now;
+  int64_t deadline = 0, ns;
+  uint32_t seq0, seq1;
+  unsigned int i, spins = 0;
+
+  for (;;)
+    {
+      if (!((seq0 = __atomic_load_n (&shm->seq, __ATOMIC_ACQUIRE)) & 1))
+	{
+	  for (i = 0; i < UPTIME_SHM_FIELDS; i++)
+	    copy.words[i] = __atomic_load_n (&src[i], __ATOMIC_RELAXED);
+	  __atomic_thread_fence (__ATOMIC_ACQUIRE);
+	  seq1 = __atomic_load_n (&shm->seq, __ATOMIC_RELAXED);
+	  if (seq0 == seq1)
+	    break;
+	}
+      if (++spins < UPTIME_SHM_SPINS)
+	continue;
+
+      clock_gettime (CLOCK_MONOTONIC, &now);
+      ns = (int64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+      if (deadline == 0)
+	deadline = ns + (int64_t) UPTIME_SHM_READ_TIMEOUT_MS * 1000000;
+      else if (ns > deadline)
+	return -1;
+      sched_yield ();
+    }
+  *snap = copy.snap;
+
+  return (seq0 == 0) ? -1 : 0;
+}
+
+/*
+ * Returns TRUE if the publisher of 'snap' missed more than
+ * UPTIME_SHM_MAX_MISSED updates at the time 'now': it is dead or hung and
+ * the published boot time can no longer be trusted
+ */
+static inline int
+uptime_shm_stale (const struct uptime_shm_snapshot *snap, int64_t now)
+{
+  int64_t interval = (snap->interval > 0) ? snap->interval : 1;
+
+  return now - snap->updated_at > UPTIME_SHM_MAX_MISSED * interval + 1;
+}
@@ -0,0 +1,96 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * libuptimecheck - the check_uptime plugin as a reentrant C library
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include "nputils.h"
+#include "uptime.h"
+#include "uptimecheck.h"
+
+int
+uptimecheck_set_thresholds (uptimecheck_thresholds * my_thresholds,
+			    const char *warning, const char *critical)
+{
+  if (set_thresholds (my_thresholds, warning, critical) != 0)
+    return UPTIMECHECK_EINVAL;
+  return UPTIMECHECK_OK;
+}
+
+int
+uptimecheck_uptime (time_t * uptime_secs)
+{
+  if (UPTIME_RET_FAIL == (*uptime_secs = uptime ()))
+    return UPTIMECHECK_ENOUPTIME;
+  return UPTIMECHECK_OK;
+}
+
+int
+uptimecheck_state (time_t uptime_secs,
+		   const uptimecheck_thresholds * my_thresholds)
+{
+  return get_status ((unsigned int) (uptime_secs / 60), my_thresholds);
+}
+
+int
+uptimecheck_format (char *line, size_t size, time_t uptime_secs,
+		    const uptimecheck_thresholds * my_thresholds, int *state)
+{
+  size_t len = sprint_check_line (line, size, uptime_secs, my_thresholds,
+				  state);
+
+  return (len < size) ? UPTIMECHECK_OK : UPTIMECHECK_ETRUNC;
+}
+
+int
+uptimecheck_run (char *line, size_t size,
+		 const uptimecheck_thresholds * my_thresholds, int *state)
+{
+  time_t uptime_secs;
+
+  if (uptimecheck_uptime (&uptime_secs) != UPTIMECHECK_OK)
+    {
+      if (size > 0)
+	snprintf (line, size,
+		  "UPTIME UNKNOWN: can't get system uptime counter");
+      *state = STATE_UNKNOWN;
+      return UPTIMECHECK_ENOUPTIME;
+    }
+
+  return uptimecheck_format (line, size, uptime_secs, my_thresholds, state);
+}
+
+const char *
+uptimecheck_strerror (int error)
+{
+  switch (error)
+    {
+    case UPTIMECHECK_OK:
+      return "success";
+    case UPTIMECHECK_EINVAL:
+      return "unparseable threshold";
+    case UPTIMECHECK_ENOUPTIME:
+      return "can't get system uptime counter";
+    case UPTIMECHECK_ETRUNC:
+      return "output buffer too small";
+    }
+  return "unknown error";
+}
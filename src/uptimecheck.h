@@ -0,0 +1,91 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * libuptimecheck - the check_uptime plugin as a reentrant C library
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UPTIMECHECK_H
+#define UPTIMECHECK_H
+
+/*
+ * All the functions only write to the memory given by the caller and
+ * never exit, so they can be called concurrently from any thread.
+ */
+
+#include <stddef.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define UPTIMECHECK_API_VERSION  1
+
+/* Error codes */
+#define UPTIMECHECK_OK           0
+#define UPTIMECHECK_EINVAL       1	/* unparseable threshold */
+#define UPTIMECHECK_ENOUPTIME    2	/* the uptime counter is not available */
+#define UPTIMECHECK_ETRUNC       3	/* the output buffer is too small */
+
+/* Nagios states */
+#define UPTIMECHECK_STATE_OK        0
+#define UPTIMECHECK_STATE_WARNING   1
+#define UPTIMECHECK_STATE_CRITICAL  2
+#define UPTIMECHECK_STATE_UNKNOWN   3
+
+/* Size of an output buffer always large enough */
+#define UPTIMECHECK_LINE_MAX     128
+
+/* A closed interval; start and end are +/-HUGE_VAL when infinite */
+typedef struct uptimecheck_range
+{
+  double start;
+  double end;
+  int alert_on;			/* 0: alert outside the range, 1: inside */
+} uptimecheck_range;
+
+typedef struct uptimecheck_thresholds
+{
+  uptimecheck_range warning;
+  uptimecheck_range critical;
+} uptimecheck_thresholds;
+
+/* Parse the Nagios ranges 'warning' and 'critical' (both can be NULL) */
+int uptimecheck_set_thresholds (uptimecheck_thresholds *, const char *,
+				const char *);
+
+/* Read the system uptime in seconds */
+int uptimecheck_uptime (time_t *);
+
+/* Return the state of an uptime (in seconds) */
+int uptimecheck_state (time_t, const uptimecheck_thresholds *);
+
+/* Format the plugin output line and return the state in the last argument */
+int uptimecheck_format (char *, size_t, time_t,
+			const uptimecheck_thresholds *, int *);
+
+/* Run the whole check, like the plugin itself does */
+int uptimecheck_run (char *, size_t, const uptimecheck_thresholds *, int *);
+
+const char *uptimecheck_strerror (int);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPTIMECHECK_H */
@@ -0,0 +1,136 @@
+/*
+ * License: GPL
+ * Copyright (c) 2026 Davide Madrisan <davide.madrisan@gmail.com>
+ *
+ * Count of the reboots recorded in the wtmp file
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * wtmp only grows, and the records are appended in time order, so the
+ * file is mapped and scanned backward from its last record, stopping at
+ * the first record older than the window: the cost depends on the number
+ * of records in the window and not on the size of the file.
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#if HAVE_UTMPX_H
+#include <utmpx.h>
+#endif
+
+#include "nputils.h"
+#include "uptime.h"
+#include "wtmp.h"
+
+#if HAVE_UTMPX_H
+
+/*
+ * Count in 'count' the boot records of the wtmp file 'path' at or after
+ * 'since'.  Returns 0 if okay, otherwise -1
+ */
+int
+wtmp_count_reboots (const char *path, time_t since, unsigned int *count)
+{
+  const struct utmpx *ut;
+  struct stat st;
+  size_t records;
+  void *addr;
+  int fd;
+
+  *count = 0;
+  if ((fd = open (path, O_RDONLY | O_CLOEXEC)) < 0)
+    return -1;
+  if (fstat (fd, &st) < 0)
+    {
+      close (fd);
+      return -1;
+    }
+
+  records = (size_t) st.st_size / sizeof (struct utmpx);
+  if (records == 0)
+    {
+      close (fd);
+      return 0;
+    }
+
+  addr = mmap (NULL, records * sizeof (struct utmpx), PROT_READ,
+	       MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (MAP_FAILED == addr)
+    return -1;
+
+  for (ut = (const struct utmpx *) addr + records;
+       ut-- > (const struct utmpx *) addr && ut->ut_tv.tv_sec >= since;)
+    if (ut->ut_type == BOOT_TIME)
+      (*count)++;
+
+  munmap (addr, records * sizeof (struct utmpx));
+
+  return 0;
+}
+
+#else
+
+int
+wtmp_count_reboots (const char *path __attribute__ ((__unused__)),
+		    time_t since __attribute__ ((__unused__)),
+		    unsigned int *count)
+{
+  *count = 0;
+  return -1;
+}
+
+#endif /* HAVE_UTMPX_H */
+
+/*
+ * Check the uptime and the number of reboots recorded in the wtmp file
+ * 'path' in the last 'window_secs' seconds ('window' as given by the user)
+ */
+int
+wtmp_check (const char *path, const char *window, time_t window_secs,
+	    const thresholds * my_threshold,
+	    const thresholds * reboot_threshold)
+{
+  char result_line[160];
+  time_t uptime_secs;
+  unsigned int reboots;
+  int status;
+
+  if (UPTIME_RET_FAIL == (uptime_secs = uptime ()))
+    {
+      printf ("UPTIME UNKNOWN: can't get system uptime counter\n");
+      return STATE_UNKNOWN;
+    }
+  if (wtmp_count_reboots (path, time (NULL) - window_secs, &reboots) < 0)
+    {
+      printf ("UPTIME UNKNOWN: cannot read the wtmp file %s\n", path);
+      return STATE_UNKNOWN;
+    }
+
+  status = sprint_reboots_result (result_line, sizeof (result_line),
+				  uptime_secs, reboots, FALSE, window,
+				  my_threshold, reboot_threshold);
+  printf ("%s\n", result_line);
+
+  return status;
+}
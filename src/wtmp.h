@@ -0,0 +1,11 @@
+#pragma once
+
+#include <time.h>
+
+#include "nputils.h"
+
+#define WTMP_PATH  "/var/log/wtmp"
+
+int wtmp_count_reboots (const char *, time_t, unsigned int *);
+int wtmp_check (const char *, const char *, time_t, const thresholds *,
+		const thresholds *);